@@ -0,0 +1,197 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <iomanip>
+
+static volatile UWord sink = 0;
+
+static double nanoseconds(Stopwatch::Clock::duration d)
+{
+  return static_cast<double>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()
+    );
+}
+
+static void writeJsonString(std::ostream& os, const std::string& s)
+{
+  os << '"';
+  for (auto c : s)
+  {
+    if (c == '"' || c == '\\')
+    {
+      os << '\\';
+    }
+    os << c;
+  }
+  os << '"';
+}
+
+static void writeJsonPairs(std::ostream& os, 
+  const std::vector<std::pair<std::string, double>>& pairs)
+{
+  os << "{";
+  for (std::size_t i = 0; i < pairs.size(); i++)
+  {
+    os << (i > 0 ? ", " : "");
+    writeJsonString(os, pairs[i].first);
+    os << ": " << pairs[i].second;
+  }
+  os << "}";
+}
+
+void consume(UWord value)
+{
+  sink = sink + value;
+}
+
+Stopwatch::Stopwatch(PerfEvents& events)
+  : events(events),
+    elapsed(Clock::duration::zero()),
+    started(),
+    counts(events.counterNames().size(), 0),
+    startCounts()
+{
+}
+
+void Stopwatch::start()
+{
+  if (events.isOpen())
+  {
+    startCounts = events.read();
+    events.start();
+  }
+  started = Clock::now();
+}
+
+void Stopwatch::stop()
+{
+  elapsed += Clock::now() - started;
+  if (events.isOpen())
+  {
+    events.stop();
+    auto values = events.read();
+    for (std::size_t i = 0; i < counts.size(); i++)
+    {
+      counts[i] += values[i] - startCounts[i];
+    }
+  }
+}
+
+Stopwatch::Clock::duration Stopwatch::total() const
+{
+  return elapsed;
+}
+
+const std::vector<PerfEvents::Counter>& Stopwatch::eventCounts() const
+{
+  return counts;
+}
+
+double BenchmarkResult::medianNsPerOp() const
+{
+  auto sorted = nsPerOp;
+  std::sort(sorted.begin(), sorted.end());
+  return sorted.empty() ? 0 : sorted[sorted.size() / 2];
+}
+
+double BenchmarkResult::minNsPerOp() const
+{
+  return nsPerOp.empty() ? 0 : *std::min_element(nsPerOp.begin(), nsPerOp.end());
+}
+
+BenchmarkRunner::BenchmarkRunner(Stopwatch::Clock::duration minTime, 
+  std::size_t repetitions, const std::string& filter, bool hardwareCounters)
+  : minTime(minTime),
+    repetitions(std::max<std::size_t>(repetitions, 1)),
+    filter(filter),
+    events(),
+    results()
+{
+  if (hardwareCounters)
+  {
+    events.open();
+  }
+}
+
+BenchmarkResult* BenchmarkRunner::run(const std::string& name, 
+  BenchmarkBody body)
+{
+  if (name.find(filter) == std::string::npos)
+  {
+    return nullptr;
+  }
+
+  // double the iterations until a run takes long enough
+  std::size_t iterations = 1;
+  while (true)
+  {
+    Stopwatch watch(events);
+    body(iterations, watch);
+    if (watch.total() >= minTime)
+    {
+      break;
+    }
+    iterations *= 2;
+  }
+
+  results.push_back(BenchmarkResult());
+  auto& result = results.back();
+  result.name = name;
+  result.iterations = iterations;
+
+  double best = 0;
+  for (std::size_t r = 0; r < repetitions; r++)
+  {
+    Stopwatch watch(events);
+    body(iterations, watch);
+    auto ns = nanoseconds(watch.total()) / iterations;
+    result.nsPerOp.push_back(ns);
+
+    if (r == 0 || ns < best)
+    {
+      best = ns;
+      result.counters.clear();
+      const auto& counts = watch.eventCounts();
+      for (std::size_t i = 0; i < counts.size(); i++)
+      {
+        result.counters.push_back(std::make_pair(events.counterNames()[i],
+          static_cast<double>(counts[i]) / iterations));
+      }
+    }
+  }
+
+  return &result;
+}
+
+bool BenchmarkRunner::hardwareCounters() const
+{
+  return events.isOpen();
+}
+
+void BenchmarkRunner::writeJson(std::ostream& os) const
+{
+  os << std::fixed << std::setprecision(3);
+  os << "{\n  \"hardware_counters\": " 
+    << (hardwareCounters() ? "true" : "false") << ",\n";
+  os << "  \"benchmarks\": [";
+  for (std::size_t i = 0; i < results.size(); i++)
+  {
+    const auto& result = results[i];
+    os << (i > 0 ? ",\n" : "\n") << "    {\"name\": ";
+    writeJsonString(os, result.name);
+    os << ", \"iterations\": " << result.iterations 
+      << ", \"ns_per_op\": " << result.medianNsPerOp()
+      << ", \"min_ns_per_op\": " << result.minNsPerOp()
+      << ", \"repetitions\": [";
+    for (std::size_t r = 0; r < result.nsPerOp.size(); r++)
+    {
+      os << (r > 0 ? ", " : "") << result.nsPerOp[r];
+    }
+    os << "], \"counters\": ";
+    writeJsonPairs(os, result.counters);
+    os << ", \"metrics\": ";
+    writeJsonPairs(os, result.metrics);
+    os << "}";
+  }
+  os << "\n  ]\n}" << std::endl;
+  os.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,104 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "types.h"
+#include "PerfEvents.h"
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Times the measured parts of a benchmark body, and counts host hardware 
+ * events over the same intervals when they are available.
+ */
+class Stopwatch
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+private:
+  PerfEvents& events;
+  Clock::duration elapsed;
+  Clock::time_point started;
+  std::vector<PerfEvents::Counter> counts;
+  std::vector<PerfEvents::Counter> startCounts;
+
+public:
+  explicit Stopwatch(PerfEvents& events);
+  Stopwatch& operator=(const Stopwatch&) = delete;
+
+  void start();
+  void stop();
+
+  Clock::duration total() const;
+  const std::vector<PerfEvents::Counter>& eventCounts() const;
+};
+
+/**
+ * Runs iterations of the operation being measured, calling start() and 
+ * stop() on the watch around the parts that count.
+ */
+using BenchmarkBody = std::function<void(std::size_t iterations, 
+  Stopwatch& watch)>;
+
+struct BenchmarkResult
+{
+  std::string name;
+  // iterations in each repetition
+  std::size_t iterations;
+  // nanoseconds per iteration of each repetition
+  std::vector<double> nsPerOp;
+  // hardware events per iteration, from the fastest repetition
+  std::vector<std::pair<std::string, double>> counters;
+  // benchmark specific values
+  std::vector<std::pair<std::string, double>> metrics;
+
+  double medianNsPerOp() const;
+  double minNsPerOp() const;
+};
+
+/**
+ * Calibrates and repeats benchmarks, collecting their results.
+ */
+class BenchmarkRunner
+{
+private:
+  const Stopwatch::Clock::duration minTime;
+  const std::size_t repetitions;
+  const std::string filter;
+  PerfEvents events;
+  // a deque so returned results stay valid
+  std::deque<BenchmarkResult> results;
+
+public:
+  /**
+   * Each benchmark runs enough iterations to take at least minTime, then 
+   * repeats that many iterations repetitions times.  Only benchmarks whose 
+   * name contains filter are run.  Hardware counters are collected when 
+   * requested and available.
+   */
+  BenchmarkRunner(Stopwatch::Clock::duration minTime, std::size_t repetitions,
+    const std::string& filter, bool hardwareCounters);
+  BenchmarkRunner(const BenchmarkRunner&) = delete;
+  BenchmarkRunner& operator=(const BenchmarkRunner&) = delete;
+
+  /**
+   * Runs a benchmark, returning its result or nullptr if it was filtered out.
+   */
+  BenchmarkResult* run(const std::string& name, BenchmarkBody body);
+
+  bool hardwareCounters() const;
+
+  void writeJson(std::ostream& os) const;
+};
+
+/**
+ * Keeps the compiler from discarding a computed value.
+ */
+void consume(UWord value);
+
+#endif
@@ -0,0 +1,22 @@
+#include "Encoding.h"
+
+UWord encodeItype(Byte opcode, std::size_t rs1, std::size_t rd,
+  UHalfWord immediate)
+{
+  return (static_cast<UWord>(opcode) << 26) | (static_cast<UWord>(rs1) << 21)
+    | (static_cast<UWord>(rd) << 16) | immediate;
+}
+
+UWord encodeRtype(Byte opcode, Byte funcode, std::size_t rs1,
+  std::size_t rs2, std::size_t rd)
+{
+  return (static_cast<UWord>(opcode) << 26) | (static_cast<UWord>(rs1) << 21)
+    | (static_cast<UWord>(rs2) << 16) | (static_cast<UWord>(rd) << 11)
+    | funcode;
+}
+
+UWord encodeJtype(Byte opcode, Word offset)
+{
+  return (static_cast<UWord>(opcode) << 26) 
+    | (static_cast<UWord>(offset) & 0x03ffffff);
+}
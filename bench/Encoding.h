@@ -0,0 +1,15 @@
+#ifndef __ENCODING_H__
+#define __ENCODING_H__
+
+#include "types.h"
+
+/**
+ * Builds DLX instruction words in the layouts read by InstructionFactory.
+ */
+extern UWord encodeItype(Byte opcode, std::size_t rs1, std::size_t rd,
+  UHalfWord immediate);
+extern UWord encodeRtype(Byte opcode, Byte funcode, std::size_t rs1,
+  std::size_t rs2, std::size_t rd);
+extern UWord encodeJtype(Byte opcode, Word offset);
+
+#endif
@@ -0,0 +1,139 @@
+#include "PerfEvents.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+PerfEvents::PerfEvents()
+  : fds(),
+    names()
+{
+}
+
+PerfEvents::~PerfEvents()
+{
+  close();
+}
+
+#ifdef __linux__
+
+struct EventType
+{
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+};
+
+static const EventType EVENTS[] = {
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { "cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES }
+};
+
+bool PerfEvents::open()
+{
+  close();
+  for (const auto& event : EVENTS)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd < 0)
+    {
+      close();
+      return false;
+    }
+    fds.push_back(fd);
+    names.push_back(event.name);
+  }
+  return true;
+}
+
+void PerfEvents::start()
+{
+  for (auto fd : fds)
+  {
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+void PerfEvents::stop()
+{
+  for (auto fd : fds)
+  {
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+}
+
+std::vector<PerfEvents::Counter> PerfEvents::read() const
+{
+  std::vector<Counter> values;
+  for (auto fd : fds)
+  {
+    Counter value = 0;
+    if (::read(fd, &value, sizeof(value)) != sizeof(value))
+    {
+      value = 0;
+    }
+    values.push_back(value);
+  }
+  return values;
+}
+
+void PerfEvents::close()
+{
+  for (auto fd : fds)
+  {
+    ::close(fd);
+  }
+  fds.clear();
+  names.clear();
+}
+
+#else
+
+bool PerfEvents::open()
+{
+  return false;
+}
+
+void PerfEvents::start()
+{
+}
+
+void PerfEvents::stop()
+{
+}
+
+std::vector<PerfEvents::Counter> PerfEvents::read() const
+{
+  return std::vector<Counter>();
+}
+
+void PerfEvents::close()
+{
+}
+
+#endif
+
+bool PerfEvents::isOpen() const
+{
+  return !fds.empty();
+}
+
+const std::vector<std::string>& PerfEvents::counterNames() const
+{
+  return names;
+}
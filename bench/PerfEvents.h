@@ -0,0 +1,52 @@
+#ifndef __PERFEVENTS_H__
+#define __PERFEVENTS_H__
+
+#include "types.h"
+#include <vector>
+#include <string>
+
+/**
+ * A group of host hardware counters read through perf_event_open.  Only 
+ * available on Linux, and only when the kernel allows the calling process to 
+ * count its own events.
+ */
+class PerfEvents
+{
+public:
+  using Counter = uint64_t;
+
+private:
+  std::vector<int> fds;
+  std::vector<std::string> names;
+
+public:
+  PerfEvents();
+  ~PerfEvents();
+  PerfEvents(const PerfEvents&) = delete;
+  PerfEvents& operator=(const PerfEvents&) = delete;
+
+  /**
+   * Opens the counters.  Returns false if they are not available, in which 
+   * case the other methods do nothing.
+   */
+  bool open();
+  bool isOpen() const;
+
+  void start();
+  void stop();
+
+  /**
+   * The counter names, in the order of the values returned by read().
+   */
+  const std::vector<std::string>& counterNames() const;
+
+  /**
+   * Reads the current value of each counter.
+   */
+  std::vector<Counter> read() const;
+
+private:
+  void close();
+};
+
+#endif
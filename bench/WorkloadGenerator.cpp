@@ -0,0 +1,327 @@
+#include "WorkloadGenerator.h"
+#include "Encoding.h"
+#include "Exceptions.h"
+#include <iomanip>
+#include <sstream>
+
+// opcodes and function codes from instruction_types.cpp
+static const Byte OP_INTEGER = 0;
+static const Byte OP_FLOAT = 1;
+static const Byte OP_J = 2;
+static const Byte OP_BEQZ = 4;
+static const Byte OP_ADDI = 8;
+static const Byte OP_TRAP = 17;
+static const Byte OP_LW = 35;
+static const Byte OP_LF = 38;
+static const Byte OP_SW = 43;
+static const Byte OP_SF = 46;
+
+struct RtypeOp
+{
+  Byte funcode;
+  const char* name;
+};
+
+static const RtypeOp INTEGER_OPS[] = {
+  { 32, "add" }, { 34, "sub" }, { 36, "and" }, { 37, "or" }, { 38, "xor" }
+};
+static const RtypeOp FLOAT_OPS[] = {
+  { 0, "addf" }, { 1, "subf" }, { 2, "multf" }
+};
+
+// registers written by the body, clear of those reserved by the loops
+static const std::size_t FIRST_INTEGER = 2;
+static const std::size_t NUM_INTEGER = 26;
+static const std::size_t FIRST_FLOAT = 1;
+static const std::size_t NUM_FLOAT = 31;
+
+// instructions outside the body
+static const std::size_t LOOP_INSTRUCTIONS = 11;
+static const std::size_t MAX_IMMEDIATE = 32767;
+static const std::size_t NO_DESTINATION = ~static_cast<std::size_t>(0);
+
+static std::string reg(std::size_t index, bool isFloat)
+{
+  return (isFloat ? "f" : "r") + std::to_string(index);
+}
+
+WorkloadOptions::WorkloadOptions()
+  : seed(1),
+    bodyLength(64),
+    integerWeight(50),
+    floatWeight(20),
+    loadWeight(20),
+    storeWeight(10),
+    branchDensity(0.05),
+    dependencyDistance(4),
+    innerTrips(1000),
+    outerTrips(1),
+    footprint(1024),
+    stride(4)
+{
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadOptions& options,
+  std::size_t memorySize)
+  : options(options),
+    random(options.seed),
+    code(),
+    dataBase(0),
+    destinations(),
+    destinationIsFloat(),
+    nextInteger(0),
+    nextFloat(0),
+    memoryOps(0)
+{
+  auto weights = options.integerWeight + options.floatWeight 
+    + options.loadWeight + options.storeWeight;
+  if (options.bodyLength == 0)
+  {
+    throw Exception("The loop body must contain at least one instruction");
+  }
+  if (options.branchDensity < 0 || options.branchDensity > 1)
+  {
+    throw Exception("Branch density must be between 0 and 1");
+  }
+  if (weights == 0 && options.branchDensity < 1)
+  {
+    throw Exception("The instruction mix is empty");
+  }
+  if (options.innerTrips == 0 || options.innerTrips > MAX_IMMEDIATE
+    || options.outerTrips == 0 || options.outerTrips > MAX_IMMEDIATE)
+  {
+    throw Exception("Trip counts must be between 1 and 32767");
+  }
+  if (options.stride == 0 || options.stride % 4 != 0 
+    || options.footprint < 4 || options.footprint % 4 != 0)
+  {
+    throw Exception("Footprint and stride must be non-zero multiples of 4");
+  }
+
+  // data follows the code, aligned to 16 bytes, and the last word of memory 
+  // cannot be accessed
+  auto codeBytes = (options.bodyLength + LOOP_INSTRUCTIONS) * 4;
+  dataBase = static_cast<Address>((codeBytes + 15) & ~std::size_t(15));
+  if (dataBase > MAX_IMMEDIATE || options.footprint > MAX_IMMEDIATE
+    || dataBase + options.footprint + 4 > memorySize)
+  {
+    std::ostringstream msg;
+    msg << "The program needs " << dataBase + options.footprint + 4 
+      << " bytes but memory holds " << memorySize;
+    throw Exception(msg.str());
+  }
+
+  auto outer = static_cast<Address>(2 * 4);
+  auto inner = static_cast<Address>(3 * 4);
+  auto innerDone = static_cast<Address>((6 + options.bodyLength) * 4);
+  auto done = static_cast<Address>(innerDone + 3 * 4);
+
+  emit(encodeItype(OP_ADDI, 0, BASE_REGISTER, static_cast<UHalfWord>(dataBase)),
+    "      addi r1, r0, data");
+  emit(encodeItype(OP_ADDI, 0, OUTER_COUNTER, 
+    static_cast<UHalfWord>(options.outerTrips)),
+    "      addi r28, r0, " + std::to_string(options.outerTrips));
+  emit(encodeItype(OP_ADDI, 0, INNER_COUNTER, 
+    static_cast<UHalfWord>(options.innerTrips)),
+    "outer: addi r29, r0, " + std::to_string(options.innerTrips));
+  emitBody();
+
+  auto branch = [&](std::size_t counter, Address target, const char* label) {
+    auto next = static_cast<Address>(code.size() * 4 + 4);
+    emit(encodeItype(OP_BEQZ, counter, 0, 
+      static_cast<UHalfWord>(target - next)),
+      "      beqz r" + std::to_string(counter) + ", " + label);
+  };
+  auto jump = [&](Address target, const char* label) {
+    auto next = static_cast<Address>(code.size() * 4 + 4);
+    emit(encodeJtype(OP_J, static_cast<Word>(target - next)),
+      std::string("      j ") + label);
+  };
+
+  emit(encodeItype(OP_ADDI, INNER_COUNTER, INNER_COUNTER, 0xffff),
+    "      addi r29, r29, -1");
+  branch(INNER_COUNTER, innerDone, "innerDone");
+  jump(inner, "inner");
+  emit(encodeItype(OP_ADDI, OUTER_COUNTER, OUTER_COUNTER, 0xffff),
+    "innerDone: addi r28, r28, -1");
+  branch(OUTER_COUNTER, done, "done");
+  jump(outer, "outer");
+  emit(encodeItype(OP_TRAP, FIRST_INTEGER, 0, 1), 
+    "done: trap r2, 1              ;dump register");
+  emit(encodeItype(OP_TRAP, 0, 0, 0), "      trap r0, 0");
+}
+
+void WorkloadGenerator::writeHex(std::ostream& os) const
+{
+  os << std::hex << std::setfill('0');
+  for (std::size_t i = 0; i < code.size(); i++)
+  {
+    os << std::setw(8) << i * 4 << ": " << std::setw(8) << code[i].word 
+      << "\t#" << code[i].text << "\n";
+  }
+  for (std::size_t i = 0; i < options.footprint / 4; i++)
+  {
+    os << std::setw(8) << dataBase + i * 4 << ": " << std::setw(8) 
+      << dataWord(i) << "\t#" << (i == 0 ? "data: " : "      ") << std::dec 
+      << dataWord(i) << std::hex << "\n";
+  }
+  os << std::dec << std::setfill(' ');
+}
+
+void WorkloadGenerator::load(Memory& memory) const
+{
+  for (std::size_t i = 0; i < code.size(); i++)
+  {
+    memory.writeUWord(static_cast<Address>(i * 4), code[i].word);
+  }
+  for (std::size_t i = 0; i < options.footprint / 4; i++)
+  {
+    memory.writeUWord(static_cast<Address>(dataBase + i * 4), dataWord(i));
+  }
+}
+
+void WorkloadGenerator::emit(UWord word, const std::string& text)
+{
+  code.push_back({ word, text });
+}
+
+void WorkloadGenerator::emitBody()
+{
+  // fixed point branch density, so the mix only depends on the mt19937 
+  // sequence and not on the library's distributions
+  auto branchThreshold = static_cast<uint64_t>(
+    options.branchDensity * 4294967296.0
+    );
+  auto weights = options.integerWeight + options.floatWeight 
+    + options.loadWeight + options.storeWeight;
+  auto numeric = options.integerWeight + options.floatWeight;
+
+  for (std::size_t i = 0; i < options.bodyLength; i++)
+  {
+    auto prefix = i == 0 ? "inner: " : "      ";
+    std::ostringstream text;
+    text << prefix;
+
+    if (random() < branchThreshold || weights == 0)
+    {
+      // resolves to the next instruction either way, but issue still waits 
+      // on it and on its operand
+      auto src = source(false, options.dependencyDistance);
+      emit(encodeItype(OP_BEQZ, src, 0, 0), 
+        text.str() + "beqz " + reg(src, false) + ", 0");
+      destinations.push_back(NO_DESTINATION);
+      destinationIsFloat.push_back(false);
+      continue;
+    }
+
+    auto pick = random() % weights;
+    // loads and stores use the register class of the computation mix
+    bool isFloat = numeric > 0 && random() % numeric >= options.integerWeight;
+    if (pick < options.integerWeight)
+    {
+      auto src1 = source(false, options.dependencyDistance);
+      if (random() % 6 == 0)
+      {
+        auto immediate = static_cast<UHalfWord>(1 + random() % 100);
+        auto dest = destination(false);
+        text << "addi " << reg(dest, false) << ", " << reg(src1, false) 
+          << ", " << immediate;
+        emit(encodeItype(OP_ADDI, src1, dest, immediate), text.str());
+      }
+      else
+      {
+        const auto& op = INTEGER_OPS[random() % 5];
+        auto src2 = source(false, 2 * options.dependencyDistance);
+        auto dest = destination(false);
+        text << op.name << " " << reg(dest, false) << ", " 
+          << reg(src1, false) << ", " << reg(src2, false);
+        emit(encodeRtype(OP_INTEGER, op.funcode, src1, src2, dest), 
+          text.str());
+      }
+    }
+    else if (pick < numeric)
+    {
+      const auto& op = FLOAT_OPS[random() % 3];
+      auto src1 = source(true, options.dependencyDistance);
+      auto src2 = source(true, 2 * options.dependencyDistance);
+      auto dest = destination(true);
+      text << op.name << " " << reg(dest, true) << ", " << reg(src1, true) 
+        << ", " << reg(src2, true);
+      emit(encodeRtype(OP_FLOAT, op.funcode, src1, src2, dest), text.str());
+    }
+    else if (pick < numeric + options.loadWeight)
+    {
+      auto offset = memoryOffset();
+      auto dest = destination(isFloat);
+      text << (isFloat ? "lf " : "lw ") << reg(dest, isFloat) << ", " 
+        << offset << "(r1)";
+      emit(encodeItype(isFloat ? OP_LF : OP_LW, BASE_REGISTER, dest, 
+        static_cast<UHalfWord>(offset)), text.str());
+    }
+    else
+    {
+      auto offset = memoryOffset();
+      auto src = source(isFloat, options.dependencyDistance);
+      text << (isFloat ? "sf " : "sw ") << offset << "(r1), " 
+        << reg(src, isFloat);
+      emit(encodeItype(isFloat ? OP_SF : OP_SW, BASE_REGISTER, src, 
+        static_cast<UHalfWord>(offset)), text.str());
+      destinations.push_back(NO_DESTINATION);
+      destinationIsFloat.push_back(false);
+    }
+  }
+}
+
+std::size_t WorkloadGenerator::source(bool isFloat, std::size_t distance)
+{
+  auto count = destinations.size();
+  if (distance > 0 && count >= distance)
+  {
+    for (auto i = count - distance + 1; i-- > 0;)
+    {
+      if (destinations[i] != NO_DESTINATION 
+        && destinationIsFloat[i] == isFloat)
+      {
+        return destinations[i];
+      }
+    }
+  }
+
+  return isFloat ? FIRST_FLOAT + random() % NUM_FLOAT
+    : FIRST_INTEGER + random() % NUM_INTEGER;
+}
+
+std::size_t WorkloadGenerator::destination(bool isFloat)
+{
+  // round robin, so a result lives as long as possible
+  std::size_t dest;
+  if (isFloat)
+  {
+    dest = FIRST_FLOAT + nextFloat;
+    nextFloat = (nextFloat + 1) % NUM_FLOAT;
+  }
+  else
+  {
+    dest = FIRST_INTEGER + nextInteger;
+    nextInteger = (nextInteger + 1) % NUM_INTEGER;
+  }
+
+  destinations.push_back(dest);
+  destinationIsFloat.push_back(isFloat);
+  return dest;
+}
+
+Word WorkloadGenerator::memoryOffset()
+{
+  auto slots = options.footprint / options.stride;
+  if (slots == 0)
+  {
+    slots = 1;
+  }
+  return static_cast<Word>((memoryOps++ % slots) * options.stride);
+}
+
+UWord WorkloadGenerator::dataWord(std::size_t index) const
+{
+  return static_cast<UWord>(index + 1);
+}
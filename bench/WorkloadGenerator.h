@@ -0,0 +1,106 @@
+#ifndef __WORKLOADGENERATOR_H__
+#define __WORKLOADGENERATOR_H__
+
+#include "types.h"
+#include "Memory.h"
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * The shape of a generated workload.
+ */
+struct WorkloadOptions
+{
+  WorkloadOptions();
+
+  uint32_t seed;
+  // instructions in the loop body
+  std::size_t bodyLength;
+  // relative weights of the non-branch body instructions
+  unsigned integerWeight;
+  unsigned floatWeight;
+  unsigned loadWeight;
+  unsigned storeWeight;
+  // fraction of the body that is branches
+  double branchDensity;
+  // sources read the result of the instruction this many places earlier, 0 
+  // for no forced dependencies
+  std::size_t dependencyDistance;
+  // iterations of the loop body, and of the loop around it
+  std::size_t innerTrips;
+  std::size_t outerTrips;
+  // bytes of data touched by loads and stores, and the distance between 
+  // consecutive accesses
+  std::size_t footprint;
+  std::size_t stride;
+};
+
+/**
+ * Generates DLX programs for stress testing and benchmarking.  A program 
+ * runs a randomly generated loop body inside two nested counted loops, 
+ * prints one register and halts with trap 0.  The same options and seed 
+ * always produce the same program.
+ */
+class WorkloadGenerator
+{
+private:
+  /**
+   * One instruction word with its source text.
+   */
+  struct Line
+  {
+    UWord word;
+    std::string text;
+  };
+
+  // registers reserved by the loop structure
+  static const std::size_t BASE_REGISTER = 1;
+  static const std::size_t OUTER_COUNTER = 28;
+  static const std::size_t INNER_COUNTER = 29;
+
+  const WorkloadOptions options;
+  std::mt19937 random;
+  std::vector<Line> code;
+  Address dataBase;
+  // destination of each body instruction, with its register class
+  std::vector<std::size_t> destinations;
+  std::vector<bool> destinationIsFloat;
+  std::size_t nextInteger;
+  std::size_t nextFloat;
+  std::size_t memoryOps;
+
+public:
+  /**
+   * Generates the program.  Throws an Exception if the options are invalid 
+   * or the program does not fit in memorySize bytes.
+   */
+  WorkloadGenerator(const WorkloadOptions& options, std::size_t memorySize);
+  WorkloadGenerator(const WorkloadGenerator&) = delete;
+  WorkloadGenerator& operator=(const WorkloadGenerator&) = delete;
+
+  /**
+   * Writes the program in the .hex format read by loadFromFile.
+   */
+  void writeHex(std::ostream& os) const;
+
+  /**
+   * Writes the program directly into memory.
+   */
+  void load(Memory& memory) const;
+
+private:
+  void emit(UWord word, const std::string& text);
+  void emitBody();
+  /**
+   * A source register, preferring the nearest result of the same class at 
+   * least distance instructions back.
+   */
+  std::size_t source(bool isFloat, std::size_t distance);
+  std::size_t destination(bool isFloat);
+  Word memoryOffset();
+  UWord dataWord(std::size_t index) const;
+};
+
+#endif
@@ -0,0 +1,519 @@
+#include "Benchmark.h"
+#include "Encoding.h"
+#include "WorkloadGenerator.h"
+#include "log.h"
+#include "Memory.h"
+#include "MachineConfig.h"
+#include "Loader.h"
+#include "Tomasulo.h"
+#include "RegisterFile.h"
+#include "RenameRegisterFile.h"
+#include "CommonDataBus.h"
+#include "FunctionalUnit.h"
+#include "ReservationStation.h"
+#include "Exceptions.h"
+#include "instructions/InstructionFactory.h"
+#include "tclap/CmdLine.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace util;
+
+static const std::string TAG = "bench";
+
+const StrongLogPtr logger(new Log("tomasulo bench"));
+
+/**
+ * Encapsulates the command line options.
+ */
+struct ArgPack
+{
+  std::string filter;
+  std::size_t minTimeMillis;
+  std::size_t repetitions;
+  std::string inputPath;
+  bool hardwareCounters;
+  std::string outputFileName;
+  std::string generateFileName;
+  WorkloadOptions workload;
+};
+
+/**
+ * The parts of a machine shared by the component benchmarks, wired together
+ * the same way as in Tomasulo.
+ */
+struct Machine
+{
+  Machine();
+  Machine& operator=(const Machine&) = delete;
+
+  Address pc;
+  bool pcStall;
+  std::size_t clock;
+  std::ostringstream output;
+  MemoryPtr memory;
+  RegisterFilePtr registers;
+  RenameRegisterFilePtr renameRegisters;
+  PerformanceCountersPtr counters;
+  CommonDataBusPtr cdb;
+  InstructionFactoryPtr factory;
+  ReservationStationDependencies deps;
+};
+
+/**
+ * Parses the command line, storing the results in an ArgPack.
+ */
+static bool parseArgs(int argc, char* argv[], ArgPack& out);
+
+static void benchDecode(BenchmarkRunner& runner);
+static void benchMemory(BenchmarkRunner& runner);
+static void benchRegisters(BenchmarkRunner& runner);
+static void benchCommit(BenchmarkRunner& runner, std::size_t numListeners);
+static void benchAdvance(BenchmarkRunner& runner, std::size_t occupancy);
+static void benchProgram(BenchmarkRunner& runner, const std::string& path,
+  const std::string& name);
+static void benchSynthetic(BenchmarkRunner& runner, 
+  const WorkloadOptions& options, const std::string& name);
+static void runProgram(BenchmarkRunner& runner, const ByteBuffer& bytes,
+  const std::string& name);
+
+/**
+ * Writes a generated workload to a .hex file, or stdout if the name is "-".
+ */
+static bool generate(const WorkloadOptions& options, 
+  const std::string& filename);
+
+int main(int argc, char* argv[])
+{
+  ArgPack args;
+  if (!parseArgs(argc, argv, args))
+  {
+    return 1;
+  }
+
+  // match the simulator's default log level, with nowhere to write
+  logger->setLevel(LogLevel::Warning);
+
+  try
+  {
+    if (!args.generateFileName.empty())
+    {
+      return generate(args.workload, args.generateFileName) ? 0 : 1;
+    }
+
+    BenchmarkRunner runner(std::chrono::milliseconds(args.minTimeMillis),
+      args.repetitions, args.filter, args.hardwareCounters);
+    if (args.hardwareCounters && !runner.hardwareCounters())
+    {
+      std::cerr << "Hardware counters are not available" << std::endl;
+    }
+
+    benchDecode(runner);
+    benchMemory(runner);
+    benchRegisters(runner);
+    for (std::size_t n : { 1, 4, 16, 32 })
+    {
+      benchCommit(runner, n);
+    }
+    for (std::size_t n : { 0, 2, 4, 8 })
+    {
+      benchAdvance(runner, n);
+    }
+    for (const auto& program : findPrograms(args.inputPath))
+    {
+      benchProgram(runner, args.inputPath + "/" + program + ".hex", program);
+    }
+    benchSynthetic(runner, args.workload, "synthetic");
+
+    std::ofstream file;
+    if (args.outputFileName != "-")
+    {
+      file.open(args.outputFileName.c_str(), std::ios::out);
+      if (!file)
+      {
+        std::cerr << "Unable to open " << args.outputFileName << std::endl;
+        return 1;
+      }
+    }
+    std::ostream& os = args.outputFileName == "-" ? std::cout : file;
+    runner.writeJson(os);
+  }
+  catch (Exception& e)
+  {
+    std::cerr << "Aborted with exception: " << e << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+Machine::Machine()
+  : pc(0),
+    pcStall(false),
+    clock(0),
+    output(),
+    memory(new Memory(MEMORY_SIZE)),
+    registers(new RegisterFile(GPR_REGISTERS, FPR_REGISTERS)),
+    renameRegisters(new RenameRegisterFile(GPR_REGISTERS, FPR_REGISTERS)),
+    counters(new PerformanceCounters),
+    cdb(new CommonDataBus(registers, renameRegisters, counters)),
+    factory(new InstructionFactory(pc, memory, registers, output)),
+    deps(registers, renameRegisters, memory, pc, pcStall, clock, cdb, 
+      counters)
+{
+}
+
+bool parseArgs(int argc, char* argv[], ArgPack& out)
+{
+  using namespace TCLAP;
+  try
+  {
+    CmdLine cmd(
+      "Microbenchmarks for the Tomasulo simulator, written as JSON."
+      );
+    ValueArg<std::string> filter("", "filter",
+      "Only run benchmarks whose name contains this string", false, "",
+      "string", cmd
+      );
+    ValueArg<std::size_t> minTime("", "min-time",
+      "The minimum time of each repetition in milliseconds", false, 100,
+      "ms", cmd
+      );
+    ValueArg<std::size_t> repetitions("", "repetitions",
+      "The number of timed repetitions of each benchmark", false, 5, "N", cmd
+      );
+    ValueArg<std::string> inputPath("", "inputs",
+      "The directory holding the regression programs", false, "Inputs",
+      "path", cmd
+      );
+    SwitchArg hardwareCounters("", "perf",
+      "Also count host cycles, instructions, branch misses and cache misses "
+      "with perf_event_open", cmd, false
+      );
+    ValueArg<std::string> outputFileName("o", "output",
+      "Where to write the results ('-' for stdout)", false, "-", "path", cmd
+      );
+
+    // workload generation
+    WorkloadOptions defaults;
+    ValueArg<std::string> generateFileName("", "generate",
+      "Write a generated workload to a .hex file instead of benchmarking "
+      "('-' for stdout).  The options below shape it, and the synthetic "
+      "benchmark", false, "", "path", cmd
+      );
+    ValueArg<uint32_t> seed("", "seed", "The workload random seed", false,
+      defaults.seed, "N", cmd
+      );
+    ValueArg<std::size_t> bodyLength("", "body",
+      "Instructions in the workload loop body", false, defaults.bodyLength,
+      "N", cmd
+      );
+    ValueArg<std::string> mix("", "mix",
+      "Relative weights of integer, floating point, load and store "
+      "instructions in the workload", false, "50:20:20:10", 
+      "int:fp:load:store", cmd
+      );
+    ValueArg<double> branchDensity("", "branches",
+      "Fraction of the workload loop body that is branches", false,
+      defaults.branchDensity, "fraction", cmd
+      );
+    ValueArg<std::size_t> dependencyDistance("", "distance",
+      "Workload instructions read the result from this many instructions "
+      "earlier (0 for random sources)", false, defaults.dependencyDistance,
+      "N", cmd
+      );
+    ValueArg<std::size_t> innerTrips("", "trips",
+      "Iterations of the workload loop body, at most 32767", false, 
+      defaults.innerTrips, "N", cmd
+      );
+    ValueArg<std::size_t> outerTrips("", "outer-trips",
+      "Iterations of the loop around the workload loop, at most 32767", 
+      false, defaults.outerTrips, "N", cmd
+      );
+    ValueArg<std::size_t> footprint("", "footprint",
+      "Bytes of data read and written by the workload", false, 
+      defaults.footprint, "bytes", cmd
+      );
+    ValueArg<std::size_t> stride("", "stride",
+      "Bytes between consecutive workload memory accesses", false, 
+      defaults.stride, "bytes", cmd
+      );
+
+    cmd.parse(argc, argv);
+
+    out.filter = filter.getValue();
+    out.minTimeMillis = minTime.getValue();
+    out.repetitions = repetitions.getValue();
+    out.inputPath = inputPath.getValue();
+    out.hardwareCounters = hardwareCounters.getValue();
+    out.outputFileName = outputFileName.getValue();
+    out.generateFileName = generateFileName.getValue();
+    out.workload.seed = seed.getValue();
+    out.workload.bodyLength = bodyLength.getValue();
+    out.workload.branchDensity = branchDensity.getValue();
+    out.workload.dependencyDistance = dependencyDistance.getValue();
+    out.workload.innerTrips = innerTrips.getValue();
+    out.workload.outerTrips = outerTrips.getValue();
+    out.workload.footprint = footprint.getValue();
+    out.workload.stride = stride.getValue();
+
+    char sep1 = 0, sep2 = 0, sep3 = 0;
+    std::istringstream weights(mix.getValue());
+    weights >> out.workload.integerWeight >> sep1 >> out.workload.floatWeight 
+      >> sep2 >> out.workload.loadWeight >> sep3 >> out.workload.storeWeight;
+    if (!weights || sep1 != ':' || sep2 != ':' || sep3 != ':')
+    {
+      std::cerr << "Invalid --mix, expected int:fp:load:store" << std::endl;
+      return false;
+    }
+  }
+  catch (TCLAP::ArgException& e)
+  {
+    std::cerr << "Error parsing arguments: " << e.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+void benchDecode(BenchmarkRunner& runner)
+{
+  Machine machine;
+  // one instruction of each encoding and functional unit
+  const std::vector<UWord> words = {
+    encodeItype(8, 1, 2, 100),    // addi
+    encodeRtype(0, 32, 1, 2, 3),  // add
+    encodeRtype(1, 2, 1, 2, 3),   // multf
+    encodeItype(35, 1, 2, 16),    // lw
+    encodeItype(43, 1, 2, 16),    // sw
+    encodeItype(4, 1, 0, 8),      // beqz
+    encodeJtype(2, 64),           // j
+    encodeItype(17, 1, 0, 1)      // trap 1
+  };
+
+  runner.run("decode", [&](std::size_t iterations, Stopwatch& watch) {
+    watch.start();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      auto instruction = machine.factory->decode(words[i % words.size()]);
+      consume(static_cast<UWord>(instruction->getImmediate()));
+    }
+    watch.stop();
+  });
+}
+
+void benchMemory(BenchmarkRunner& runner)
+{
+  Machine machine;
+  auto& memory = *machine.memory;
+  auto words = memory.accessibleSize() / 4;
+
+  runner.run("memory/readUWord", [&](std::size_t iterations, Stopwatch& watch) {
+    watch.start();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      consume(memory.readUWord(static_cast<Address>((i % words) * 4)));
+    }
+    watch.stop();
+  });
+
+  runner.run("memory/writeUWord", [&](std::size_t iterations, Stopwatch& watch) {
+    watch.start();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      memory.writeUWord(static_cast<Address>((i % words) * 4),
+        static_cast<UWord>(i));
+    }
+    watch.stop();
+  });
+}
+
+void benchRegisters(BenchmarkRunner& runner)
+{
+  Machine machine;
+  auto& registers = *machine.registers;
+  auto& renames = *machine.renameRegisters;
+
+  runner.run("registers/read", [&](std::size_t iterations, Stopwatch& watch) {
+    watch.start();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      RegisterID reg = { i & 1 ? RegisterType::FPR : RegisterType::GPR,
+        i % GPR_REGISTERS };
+      consume(registers.read(reg).uw);
+    }
+    watch.stop();
+  });
+
+  runner.run("registers/write", [&](std::size_t iterations, Stopwatch& watch) {
+    watch.start();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      RegisterID reg = { i & 1 ? RegisterType::FPR : RegisterType::GPR,
+        i % GPR_REGISTERS };
+      Data value;
+      value.uw = static_cast<UWord>(i);
+      registers.write(reg, value);
+    }
+    watch.stop();
+  });
+
+  runner.run("rename/rename+clearRename",
+    [&](std::size_t iterations, Stopwatch& watch) {
+    watch.start();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      RegisterID reg = { RegisterType::GPR, 1 + i % (GPR_REGISTERS - 1) };
+      ReservationStationID rsid = { FunctionalUnitType::Integer, i % 8 };
+      renames.rename(reg, rsid);
+      renames.clearRename(rsid);
+    }
+    watch.stop();
+  });
+}
+
+void benchCommit(BenchmarkRunner& runner, std::size_t numListeners)
+{
+  Machine machine;
+  StationTable table(numListeners + 1);
+  std::vector<ReservationStationPtr> stations;
+  for (std::size_t i = 0; i <= numListeners; i++)
+  {
+    ReservationStationID id = { FunctionalUnitType::Integer, i };
+    stations.push_back(ReservationStationPtr(
+      new ReservationStation(id, 1, machine.deps, table, nullptr)
+      ));
+  }
+  auto& producer = *stations[0];
+  auto produce = machine.factory->decode(encodeItype(8, 0, 1, 1));
+  auto listen = machine.factory->decode(encodeRtype(0, 32, 1, 1, 2));
+
+  std::ostringstream name;
+  name << "cdb/commit/listeners:" << numListeners;
+  runner.run(name.str(), [&](std::size_t iterations, Stopwatch& watch) {
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      // every other station waits on the producer's r1
+      producer.setInstruction(produce, i);
+      for (std::size_t s = 1; s <= numListeners; s++)
+      {
+        stations[s]->setInstruction(listen, i);
+      }
+      producer.setIsExecuting();
+      producer.execute();
+      producer.setIsWriting();
+      producer.write();
+
+      watch.start();
+      machine.cdb->commit();
+      watch.stop();
+
+      for (auto& rs : stations)
+      {
+        rs->clearInstruction();
+      }
+    }
+  });
+}
+
+void benchAdvance(BenchmarkRunner& runner, std::size_t occupancy)
+{
+  Machine machine;
+  FunctionalUnit fu(FunctionalUnitType::Integer, false, 1, 8, 3, machine.deps,
+    machine.counters);
+
+  // r1 is produced by a station that never writes, so every issued
+  // instruction waits for its operand
+  ReservationStationID never = { FunctionalUnitType::FloatingPoint, 0 };
+  machine.renameRegisters->rename({ RegisterType::GPR, 1 }, never);
+  auto waiting = machine.factory->decode(encodeRtype(0, 32, 1, 2, 3));
+  for (std::size_t i = 0; i < occupancy; i++)
+  {
+    fu.issue(waiting, 0);
+  }
+
+  std::ostringstream name;
+  name << "fu/advanceInstructions/occupancy:" << occupancy;
+  runner.run(name.str(), [&](std::size_t iterations, Stopwatch& watch) {
+    watch.start();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      fu.advanceInstructions();
+    }
+    watch.stop();
+  });
+}
+
+void benchProgram(BenchmarkRunner& runner, const std::string& path,
+  const std::string& name)
+{
+  Memory image(MEMORY_SIZE);
+  if (!loadFromFile(image, path))
+  {
+    std::cerr << "Unable to load " << path << ", skipping" << std::endl;
+    return;
+  }
+  runProgram(runner, image.snapshot(), "program/" + name);
+}
+
+void benchSynthetic(BenchmarkRunner& runner, const WorkloadOptions& options,
+  const std::string& name)
+{
+  Memory image(MEMORY_SIZE);
+  WorkloadGenerator(options, image.size()).load(image);
+  runProgram(runner, image.snapshot(), "program/" + name);
+}
+
+void runProgram(BenchmarkRunner& runner, const ByteBuffer& bytes,
+  const std::string& name)
+{
+  std::ostringstream discard;
+  std::size_t cycles = 0;
+  auto result = runner.run(name, [&](std::size_t iterations, Stopwatch& watch) {
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+      MemoryPtr memory(new Memory(MEMORY_SIZE));
+      memory->write(0, bytes);
+      Tomasulo tomasulo(memory, false, false, 0, discard);
+
+      watch.start();
+      tomasulo.run();
+      watch.stop();
+
+      discard.str("");
+      cycles = tomasulo.clocks();
+    }
+  });
+
+  if (result)
+  {
+    auto ns = result->medianNsPerOp();
+    result->metrics.push_back(std::make_pair("simulated_cycles",
+      static_cast<double>(cycles)));
+    result->metrics.push_back(std::make_pair("simulated_cycles_per_second",
+      ns > 0 ? cycles * 1e9 / ns : 0));
+  }
+}
+
+bool generate(const WorkloadOptions& options, const std::string& filename)
+{
+  WorkloadGenerator generator(options, MEMORY_SIZE);
+
+  std::ofstream file;
+  if (filename != "-")
+  {
+    file.open(filename.c_str(), std::ios::out);
+    if (!file)
+    {
+      std::cerr << "Unable to open " << filename << std::endl;
+      return false;
+    }
+  }
+  std::ostream& os = filename == "-" ? std::cout : file;
+
+  generator.writeHex(os);
+  return static_cast<bool>(os);
+}
@@ -0,0 +1,57 @@
+#include "Baseline.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+bool readBaseline(const std::string& filename, Baseline& out)
+{
+  std::ifstream file(filename.c_str(), std::ios::in);
+  if (!file)
+  {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+
+    std::istringstream is(line);
+    std::string name;
+    BaselineEntry entry;
+    if (is >> name >> entry.cycles)
+    {
+      if (!(is >> entry.nsPerCycle))
+      {
+        entry.nsPerCycle = 0;
+      }
+      out[name] = entry;
+    }
+  }
+  return true;
+}
+
+bool writeBaseline(const std::string& filename, const Baseline& baseline)
+{
+  std::ofstream file(filename.c_str(), std::ios::out);
+  if (!file)
+  {
+    return false;
+  }
+
+  file << "# program cycles [ns_per_cycle]\n";
+  file << std::fixed << std::setprecision(1);
+  for (const auto& entry : baseline)
+  {
+    file << entry.first << " " << entry.second.cycles;
+    if (entry.second.nsPerCycle > 0)
+    {
+      file << " " << entry.second.nsPerCycle;
+    }
+    file << "\n";
+  }
+  return static_cast<bool>(file);
+}
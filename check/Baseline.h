@@ -0,0 +1,32 @@
+#ifndef __BASELINE_H__
+#define __BASELINE_H__
+
+#include "types.h"
+#include <map>
+#include <string>
+
+/**
+ * The expected simulated cycles and host speed of a program.  nsPerCycle is 0 
+ * when the host time is not part of the baseline.
+ */
+struct BaselineEntry
+{
+  uint64_t cycles;
+  double nsPerCycle;
+};
+
+/**
+ * Baseline results by program name, stored as a text file with one 
+ * "name cycles [ns_per_cycle]" line per program.
+ */
+using Baseline = std::map<std::string, BaselineEntry>;
+
+/**
+ * Reads a baseline file.  Returns false if it cannot be read.
+ */
+extern bool readBaseline(const std::string& filename, Baseline& out);
+
+extern bool writeBaseline(const std::string& filename, 
+  const Baseline& baseline);
+
+#endif
@@ -0,0 +1,463 @@
+#include "Baseline.h"
+#include "log.h"
+#include "Memory.h"
+#include "MachineConfig.h"
+#include "Loader.h"
+#include "Tomasulo.h"
+#include "tclap/CmdLine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace util;
+
+const StrongLogPtr logger(new Log("tomasulo check"));
+
+// times each program is returned to when measuring host time
+static const std::size_t TIMING_ROUNDS = 5;
+
+/**
+ * Encapsulates the command line options.
+ */
+struct ArgPack
+{
+  std::string inputPath;
+  std::string baselineFileName;
+  bool updateBaseline;
+  std::string speedBaselineFileName;
+  std::size_t jobs;
+  std::size_t minTimeMillis;
+  double threshold;
+};
+
+/**
+ * The outcome of running one program.
+ */
+struct CheckResult
+{
+  std::string name;
+  bool outputMatches;
+  std::string problem;
+  uint64_t cycles;
+  double nsPerCycle;
+  // the program's memory image, kept for timing
+  ByteBuffer image;
+};
+
+/**
+ * Parses the command line, storing the results in an ArgPack.
+ */
+static bool parseArgs(int argc, char* argv[], ArgPack& out);
+
+/**
+ * Reads a whole file into a string.  Returns false if it cannot be read.
+ */
+static bool readFile(const std::string& filename, std::string& out);
+
+/**
+ * Runs a program and compares its output with the expected output.
+ */
+static void checkProgram(const std::string& path, CheckResult& result);
+
+/**
+ * Times repeated runs of a checked program for at least minTime, keeping
+ * the fastest in nsPerCycle.
+ */
+static void timeProgram(std::size_t minTimeMillis, CheckResult& result);
+
+/**
+ * Writes the measured cycles, and host times when timed is set, of every 
+ * program to a baseline file.
+ */
+static bool writeResults(const std::string& filename, 
+  const std::vector<CheckResult>& results, bool timed);
+
+/**
+ * Describes the first place where the output differs from the expected
+ * output.
+ */
+static std::string describeMismatch(const std::string& expected,
+  const std::string& actual);
+
+int main(int argc, char* argv[])
+{
+  ArgPack args;
+  if (!parseArgs(argc, argv, args))
+  {
+    return 1;
+  }
+
+  // only errors are interesting, and the log is shared by every worker
+  logger->setLevel(LogLevel::Error);
+
+  auto names = findPrograms(args.inputPath);
+  if (names.empty())
+  {
+    std::cerr << "No programs found in " << args.inputPath << std::endl;
+    return 1;
+  }
+
+  Baseline baseline;
+  if (!args.updateBaseline &&
+    !readBaseline(args.baselineFileName, baseline))
+  {
+    std::cerr << "Could not read the baseline " << args.baselineFileName
+      << ", run with --update-baseline to create it" << std::endl;
+    return 1;
+  }
+
+  std::vector<CheckResult> results(names.size());
+  for (std::size_t i = 0; i < names.size(); i++)
+  {
+    results[i].name = names[i];
+  }
+
+  std::atomic<std::size_t> next(0);
+  auto worker = [&]() {
+    std::size_t i;
+    while ((i = next++) < results.size())
+    {
+      checkProgram(args.inputPath + "/" + results[i].name, results[i]);
+    }
+  };
+
+  auto jobs = std::max<std::size_t>(1, std::min(args.jobs, results.size()));
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < jobs; i++)
+  {
+    workers.emplace_back(worker);
+  }
+  for (auto& t : workers)
+  {
+    t.join();
+  }
+
+  // host time is only measured when asked for, one program at a time so 
+  // they do not compete for the host
+  bool timing = !args.speedBaselineFileName.empty();
+  Baseline speedBaseline;
+  bool haveSpeedBaseline = timing 
+    && readBaseline(args.speedBaselineFileName, speedBaseline);
+  if (timing)
+  {
+    // spreading each program over rounds keeps a burst of load on the host 
+    // from slowing all of its runs
+    for (std::size_t round = 0; round < TIMING_ROUNDS; round++)
+    {
+      for (auto& result : results)
+      {
+        if (result.outputMatches)
+        {
+          timeProgram(args.minTimeMillis / TIMING_ROUNDS, result);
+        }
+      }
+    }
+  }
+
+  std::size_t passed = 0;
+  double logRatios = 0;
+  std::size_t timed = 0;
+  std::cout << std::fixed << std::setprecision(1);
+  for (const auto& result : results)
+  {
+    bool ok = result.outputMatches;
+    std::string detail = result.problem;
+
+    if (ok && !args.updateBaseline)
+    {
+      auto entry = baseline.find(result.name);
+      if (entry == baseline.end())
+      {
+        ok = false;
+        detail = "not in the baseline";
+      }
+      else if (result.cycles != entry->second.cycles)
+      {
+        ok = false;
+        std::ostringstream os;
+        os << "cycles changed from " << entry->second.cycles << " to "
+          << result.cycles;
+        detail = os.str();
+      }
+    }
+
+    auto speed = speedBaseline.find(result.name);
+    bool compareSpeed = speed != speedBaseline.end() 
+      && speed->second.nsPerCycle > 0 && result.nsPerCycle > 0;
+    if (compareSpeed)
+    {
+      logRatios += std::log(result.nsPerCycle / speed->second.nsPerCycle);
+      timed++;
+    }
+
+    if (ok)
+    {
+      passed++;
+    }
+    std::cout << (ok ? "PASS " : "FAIL ") << std::left << std::setw(10)
+      << result.name << std::right << std::setw(8) << result.cycles
+      << " cycles";
+    if (timing)
+    {
+      std::cout << " " << std::setw(8) << result.nsPerCycle << " ns/cycle";
+    }
+    if (compareSpeed)
+    {
+      std::cout << " (baseline " << speed->second.nsPerCycle << ")";
+    }
+    if (!detail.empty())
+    {
+      std::cout << "  " << detail;
+    }
+    std::cout << "\n";
+  }
+
+  std::cout << "\n" << passed << " out of " << results.size()
+    << " passed.\n";
+  bool success = passed == results.size();
+
+  // individual programs are too short to time reliably, so speed is judged
+  // on the geometric mean of their slowdowns
+  if (timed > 0)
+  {
+    double slowdown = std::exp(logRatios / timed);
+    std::cout << "Host time is " << (slowdown * 100.0)
+      << "% of the baseline (limit " << (100.0 + args.threshold) << "%).\n";
+    if (slowdown > 1.0 + args.threshold / 100.0)
+    {
+      std::cout << "Simulation speed dropped beyond the threshold.\n";
+      success = false;
+    }
+  }
+
+  // host times only compare on the same machine, so the first timed run 
+  // creates the speed baseline
+  if (timing && !haveSpeedBaseline && success)
+  {
+    if (!writeResults(args.speedBaselineFileName, results, true))
+    {
+      std::cerr << "Could not write " << args.speedBaselineFileName 
+        << std::endl;
+      return 1;
+    }
+    std::cout << "Wrote " << args.speedBaselineFileName << "\n";
+  }
+
+  if (args.updateBaseline)
+  {
+    if (passed != results.size())
+    {
+      std::cerr << "Not updating the baseline while programs fail"
+        << std::endl;
+      return 1;
+    }
+
+    if (!writeResults(args.baselineFileName, results, false))
+    {
+      std::cerr << "Could not write " << args.baselineFileName << std::endl;
+      return 1;
+    }
+    std::cout << "Wrote " << args.baselineFileName << "\n";
+  }
+
+  return success ? 0 : 1;
+}
+
+bool parseArgs(int argc, char* argv[], ArgPack& out)
+{
+  using namespace TCLAP;
+  try
+  {
+    CmdLine cmd(
+      "Runs the regression programs in parallel, checking their output and "
+      "comparing cycles against a baseline, and optionally host time."
+      );
+    ValueArg<std::string> inputPath("", "inputs",
+      "The directory holding the .hex programs and their .out files", false,
+      "Inputs", "path", cmd
+      );
+    ValueArg<std::string> baselineFileName("", "baseline",
+      "The file holding the expected cycles of each program",
+      false, "Inputs/baseline.txt", "path", cmd
+      );
+    SwitchArg updateBaseline("", "update-baseline",
+      "Write the measured cycles to the baseline instead of comparing "
+      "against it", cmd, false
+      );
+    ValueArg<std::string> speedBaselineFileName("", "speed-baseline",
+      "Time each program after checking them all, and compare the host time "
+      "with this file, which is written by the first timed run.  Host times "
+      "only compare on the machine that wrote the file", false, "", "path", 
+      cmd
+      );
+    ValueArg<std::size_t> jobs("j", "jobs",
+      "The number of programs to run at once", false,
+      std::max(1u, std::thread::hardware_concurrency()), "N", cmd
+      );
+    ValueArg<std::size_t> minTime("", "min-time",
+      "The minimum time spent timing each program for --speed-baseline, in "
+      "milliseconds", false,
+      200, "ms", cmd
+      );
+    ValueArg<double> threshold("", "threshold",
+      "Fail when host time grows by more than this percentage", false, 8,
+      "percent", cmd
+      );
+
+    cmd.parse(argc, argv);
+
+    out.inputPath = inputPath.getValue();
+    out.baselineFileName = baselineFileName.getValue();
+    out.updateBaseline = updateBaseline.getValue();
+    out.speedBaselineFileName = speedBaselineFileName.getValue();
+    out.jobs = jobs.getValue();
+    out.minTimeMillis = minTime.getValue();
+    out.threshold = threshold.getValue();
+  }
+  catch (TCLAP::ArgException& e)
+  {
+    std::cerr << "Error parsing arguments: " << e.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool readFile(const std::string& filename, std::string& out)
+{
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+
+  std::ostringstream os;
+  os << file.rdbuf();
+  out = os.str();
+  return true;
+}
+
+void checkProgram(const std::string& path, CheckResult& result)
+{
+  result.outputMatches = false;
+  result.cycles = 0;
+  result.nsPerCycle = 0;
+
+  std::string expected;
+  if (!readFile(path + ".out", expected))
+  {
+    result.problem = "no expected output";
+    return;
+  }
+
+  Memory image(MEMORY_SIZE);
+  if (!loadFromFile(image, path + ".hex"))
+  {
+    result.problem = "could not load the program";
+    return;
+  }
+  result.image = image.snapshot();
+
+  MemoryPtr memory(new Memory(MEMORY_SIZE));
+  memory->write(0, result.image);
+  std::ostringstream output;
+  Tomasulo tomasulo(memory, false, false, 0, output);
+  try
+  {
+    tomasulo.run();
+  }
+  catch (std::exception& e)
+  {
+    result.problem = std::string("simulation failed: ") + e.what();
+    return;
+  }
+
+  result.cycles = tomasulo.clocks();
+  result.outputMatches = output.str() == expected;
+  if (!result.outputMatches)
+  {
+    result.problem = describeMismatch(expected, output.str());
+  }
+}
+
+void timeProgram(std::size_t minTimeMillis, CheckResult& result)
+{
+  using Clock = std::chrono::steady_clock;
+  std::chrono::nanoseconds elapsed(0);
+  // the fastest run is the one the host disturbed least, which keeps the 
+  // times steady enough for a tight threshold
+  auto fastest = Clock::duration::max();
+  std::ostringstream output;
+  do
+  {
+    MemoryPtr memory(new Memory(MEMORY_SIZE));
+    memory->write(0, result.image);
+    Tomasulo tomasulo(memory, false, false, 0, output);
+
+    auto start = Clock::now();
+    tomasulo.run();
+    auto time = Clock::now() - start;
+    elapsed += time;
+    fastest = std::min(fastest, time);
+    output.str("");
+  } while (elapsed < std::chrono::milliseconds(minTimeMillis));
+
+  if (result.cycles > 0)
+  {
+    double nsPerCycle = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(fastest).count()) 
+      / result.cycles;
+    if (result.nsPerCycle == 0 || nsPerCycle < result.nsPerCycle)
+    {
+      result.nsPerCycle = nsPerCycle;
+    }
+  }
+}
+
+bool writeResults(const std::string& filename, 
+  const std::vector<CheckResult>& results, bool timed)
+{
+  Baseline baseline;
+  for (const auto& result : results)
+  {
+    baseline[result.name] = BaselineEntry{ result.cycles, 
+      timed ? result.nsPerCycle : 0 };
+  }
+  return writeBaseline(filename, baseline);
+}
+
+std::string describeMismatch(const std::string& expected,
+  const std::string& actual)
+{
+  std::size_t line = 1;
+  std::size_t i = 0;
+  while (i < expected.size() && i < actual.size() &&
+    expected[i] == actual[i])
+  {
+    if (expected[i] == '\n')
+    {
+      line++;
+    }
+    i++;
+  }
+
+  std::ostringstream os;
+  os << "output differs at line " << line;
+  if (i >= actual.size())
+  {
+    os << " (output ends early)";
+  }
+  else if (i >= expected.size())
+  {
+    os << " (unexpected extra output)";
+  }
+  return os.str();
+}
@@ -0,0 +1,316 @@
+#include "ctomasulo.h"
+#include "log.h"
+#include "Memory.h"
+#include "Loader.h"
+#include "Tomasulo.h"
+#include <sstream>
+#include <string>
+#include <exception>
+#include <memory>
+
+using namespace util;
+
+/**
+ * Creates the library's log.  It has no writers, and only formats errors 
+ * unless the embedding program changes the level.
+ */
+static StrongLogPtr createLogger()
+{
+  StrongLogPtr log(new Log("tomasulo library"));
+  log->setLevel(LogLevel::Error);
+  return log;
+}
+
+const StrongLogPtr logger(createLogger());
+
+struct tomasulo_sim
+{
+  MemoryPtr memory;
+  std::ostringstream output;
+  std::string outputText;
+  Pointer<Tomasulo> tomasulo;
+  std::string error;
+};
+
+/**
+ * Creates a simulator with memory_size bytes of memory, then loads a program 
+ * into it with load.  Returns nullptr if load fails or throws.
+ */
+template<typename F>
+static tomasulo_sim* create(size_t memory_size, F load)
+{
+  try
+  {
+    MemoryPtr memory(new Memory(static_cast<UWord>(memory_size)));
+    if (!load(*memory))
+    {
+      return nullptr;
+    }
+
+    std::unique_ptr<tomasulo_sim> sim(new tomasulo_sim);
+    sim->memory = memory;
+    sim->tomasulo = Pointer<Tomasulo>(
+      new Tomasulo(memory, false, false, 0, sim->output)
+      );
+    return sim.release();
+  }
+  catch (std::exception&)
+  {
+    // there is no simulator to hold the error
+    return nullptr;
+  }
+}
+
+/**
+ * Runs f, recording any exception in sim.  Returns false if one was thrown.
+ */
+template<typename F>
+static bool guard(tomasulo_sim* sim, F f)
+{
+  try
+  {
+    sim->error.clear();
+    f();
+    return true;
+  }
+  catch (std::exception& e)
+  {
+    sim->error = e.what();
+    return false;
+  }
+}
+
+/**
+ * Resets sim, then loads a program into its memory with load.  Returns 0, or 
+ * -1 with the memory cleared if load fails.
+ */
+template<typename F>
+static int reload(tomasulo_sim* sim, F load)
+{
+  sim->tomasulo->reset();
+  sim->output.str("");
+  sim->output.clear();
+  sim->outputText.clear();
+  auto& memory = *sim->memory;
+  bool loaded = false;
+  if (guard(sim, [&]() { loaded = load(memory); }) && !loaded)
+  {
+    sim->error = "Unable to load the program";
+  }
+  if (!loaded)
+  {
+    memory.clear();
+    return -1;
+  }
+  return 0;
+}
+
+static RegisterID registerOf(int type, size_t index)
+{
+  return RegisterID{ type == TOMASULO_FPR ? RegisterType::FPR 
+    : RegisterType::GPR, index };
+}
+
+tomasulo_sim* tomasulo_create(const char* hex, size_t memory_size)
+{
+  return create(memory_size, [hex](Memory& memory) {
+    std::istringstream is(hex);
+    return loadFromStream(memory, is);
+  });
+}
+
+tomasulo_sim* tomasulo_create_from_file(const char* path, size_t memory_size)
+{
+  return create(memory_size, [path](Memory& memory) {
+    return loadFromFile(memory, path);
+  });
+}
+
+tomasulo_sim* tomasulo_create_from_image(const uint8_t* image, size_t size,
+  size_t memory_size)
+{
+  return create(memory_size, [image, size](Memory& memory) {
+    if (size > memory.accessibleSize())
+    {
+      return false;
+    }
+    memory.write(0, ByteBuffer(image, image + size));
+    return true;
+  });
+}
+
+void tomasulo_destroy(tomasulo_sim* sim)
+{
+  delete sim;
+}
+
+int tomasulo_reload(tomasulo_sim* sim, const char* hex)
+{
+  return reload(sim, [hex](Memory& memory) {
+    std::istringstream is(hex);
+    return loadFromStream(memory, is);
+  });
+}
+
+int tomasulo_reload_from_file(tomasulo_sim* sim, const char* path)
+{
+  return reload(sim, [path](Memory& memory) {
+    return loadFromFile(memory, path);
+  });
+}
+
+int tomasulo_reload_from_image(tomasulo_sim* sim, const uint8_t* image, 
+  size_t size)
+{
+  return reload(sim, [image, size](Memory& memory) {
+    if (size > memory.accessibleSize())
+    {
+      return false;
+    }
+    memory.write(0, ByteBuffer(image, image + size));
+    return true;
+  });
+}
+
+const char* tomasulo_error(const tomasulo_sim* sim)
+{
+  return sim->error.empty() ? nullptr : sim->error.c_str();
+}
+
+size_t tomasulo_step(tomasulo_sim* sim, size_t cycles)
+{
+  std::size_t count = 0;
+  guard(sim, [&]() { count = sim->tomasulo->step(cycles); });
+  return count;
+}
+
+int tomasulo_run_until_cycle(tomasulo_sim* sim, uint64_t cycle)
+{
+  bool reached = false;
+  if (!guard(sim, [&]() { 
+      reached = sim->tomasulo->runUntilCycle(static_cast<std::size_t>(cycle)); 
+    }))
+  {
+    return -1;
+  }
+  return reached ? 1 : 0;
+}
+
+int tomasulo_run_until_pc(tomasulo_sim* sim, uint32_t pc)
+{
+  bool reached = false;
+  if (!guard(sim, [&]() { reached = sim->tomasulo->runUntilPC(pc); }))
+  {
+    return -1;
+  }
+  return reached ? 1 : 0;
+}
+
+int tomasulo_run(tomasulo_sim* sim)
+{
+  return guard(sim, [&]() { sim->tomasulo->run(); }) ? 0 : -1;
+}
+
+int tomasulo_finished(const tomasulo_sim* sim)
+{
+  return sim->tomasulo->isFinished() ? 1 : 0;
+}
+
+uint64_t tomasulo_cycles(const tomasulo_sim* sim)
+{
+  return sim->tomasulo->clocks();
+}
+
+uint64_t tomasulo_retired(const tomasulo_sim* sim)
+{
+  return sim->tomasulo->counters().retired();
+}
+
+uint32_t tomasulo_pc(const tomasulo_sim* sim)
+{
+  return sim->tomasulo->getPC();
+}
+
+uint32_t tomasulo_gpr(const tomasulo_sim* sim, size_t index)
+{
+  uint32_t value = 0;
+  guard(const_cast<tomasulo_sim*>(sim), [&]() { 
+    value = sim->tomasulo->getRegisters().read(
+      registerOf(TOMASULO_GPR, index)).uw; 
+  });
+  return value;
+}
+
+float tomasulo_fpr(const tomasulo_sim* sim, size_t index)
+{
+  float value = 0;
+  guard(const_cast<tomasulo_sim*>(sim), [&]() { 
+    value = sim->tomasulo->getRegisters().read(
+      registerOf(TOMASULO_FPR, index)).f; 
+  });
+  return value;
+}
+
+uint32_t tomasulo_memory_word(const tomasulo_sim* sim, uint32_t address)
+{
+  uint32_t value = 0;
+  guard(const_cast<tomasulo_sim*>(sim), [&]() { 
+    value = sim->tomasulo->getMemory().readUWord(address); 
+  });
+  return value;
+}
+
+const char* tomasulo_output(tomasulo_sim* sim)
+{
+  sim->outputText = sim->output.str();
+  return sim->outputText.c_str();
+}
+
+void tomasulo_on_issue(tomasulo_sim* sim, tomasulo_issue_callback callback,
+  void* context)
+{
+  if (!callback)
+  {
+    sim->tomasulo->setIssueCallback(nullptr);
+    return;
+  }
+  sim->tomasulo->setIssueCallback(
+    [callback, context](const ReservationStationID& station,
+      const Instruction& instruction, std::size_t clock) {
+      callback(context, static_cast<int>(station.type), station.index,
+        instruction.getAddress(), clock);
+    });
+}
+
+void tomasulo_on_commit(tomasulo_sim* sim, tomasulo_commit_callback callback,
+  void* context)
+{
+  if (!callback)
+  {
+    sim->tomasulo->setCommitCallback(nullptr);
+    return;
+  }
+  sim->tomasulo->setCommitCallback(
+    [callback, context](const ReservationStationID& source,
+      const RegisterID& dest, Data value) {
+      callback(context, static_cast<int>(source.type), source.index,
+        dest.type == RegisterType::FPR ? TOMASULO_FPR : TOMASULO_GPR,
+        dest.index, value.uw);
+    });
+}
+
+void tomasulo_on_retire(tomasulo_sim* sim, tomasulo_retire_callback callback,
+  void* context)
+{
+  if (!callback)
+  {
+    sim->tomasulo->setRetireCallback(nullptr);
+    return;
+  }
+  sim->tomasulo->setRetireCallback(
+    [callback, context](const ReservationStationID& station,
+      const Instruction& instruction) {
+      callback(context, static_cast<int>(station.type), station.index,
+        instruction.getAddress());
+    });
+}
@@ -0,0 +1,108 @@
+#ifndef __CTOMASULO_H__
+#define __CTOMASULO_H__
+
+/**
+ * A C interface to libtomasulo, for use through foreign function interfaces.  
+ * Functions that can fail record a message available from tomasulo_error().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOMASULO_DEFAULT_MEMORY_SIZE 4096
+
+/* the functional unit types, as used in station identifiers */
+#define TOMASULO_UNIT_INTEGER 1
+#define TOMASULO_UNIT_TRAP 2
+#define TOMASULO_UNIT_BRANCH 3
+#define TOMASULO_UNIT_MEMORY 4
+#define TOMASULO_UNIT_FLOAT 5
+
+/* register types */
+#define TOMASULO_GPR 0
+#define TOMASULO_FPR 1
+
+typedef struct tomasulo_sim tomasulo_sim;
+
+typedef void (*tomasulo_issue_callback)(void* context, int unit, 
+  size_t station, uint32_t address, uint64_t cycle);
+typedef void (*tomasulo_commit_callback)(void* context, int unit, 
+  size_t station, int register_type, size_t register_index, uint32_t value);
+typedef void (*tomasulo_retire_callback)(void* context, int unit, 
+  size_t station, uint32_t address);
+
+/**
+ * Creates a simulator for the program in .hex text, or the .hex file at 
+ * path.  Returns NULL if the program cannot be loaded.
+ */
+tomasulo_sim* tomasulo_create(const char* hex, size_t memory_size);
+tomasulo_sim* tomasulo_create_from_file(const char* path, size_t memory_size);
+
+/**
+ * Creates a simulator whose memory starts with the size bytes of image.
+ */
+tomasulo_sim* tomasulo_create_from_image(const uint8_t* image, size_t size,
+  size_t memory_size);
+
+void tomasulo_destroy(tomasulo_sim* sim);
+
+/**
+ * Resets sim to power on and loads another program into its memory, so one 
+ * simulator can run many programs without allocating again.  Callbacks must 
+ * be set again.  Return 0, or -1 if the program cannot be loaded, which 
+ * leaves the memory empty.
+ */
+int tomasulo_reload(tomasulo_sim* sim, const char* hex);
+int tomasulo_reload_from_file(tomasulo_sim* sim, const char* path);
+int tomasulo_reload_from_image(tomasulo_sim* sim, const uint8_t* image, 
+  size_t size);
+
+/**
+ * The message of the last failure, or NULL.
+ */
+const char* tomasulo_error(const tomasulo_sim* sim);
+
+/**
+ * Simulates up to cycles cycles.  Returns the number simulated.
+ */
+size_t tomasulo_step(tomasulo_sim* sim, size_t cycles);
+
+/**
+ * Simulate until the cycle or PC is reached, or to the end of the program.  
+ * Return 1 when the target was reached, 0 when the program finished first, 
+ * and -1 on failure.
+ */
+int tomasulo_run_until_cycle(tomasulo_sim* sim, uint64_t cycle);
+int tomasulo_run_until_pc(tomasulo_sim* sim, uint32_t pc);
+int tomasulo_run(tomasulo_sim* sim);
+
+int tomasulo_finished(const tomasulo_sim* sim);
+uint64_t tomasulo_cycles(const tomasulo_sim* sim);
+uint64_t tomasulo_retired(const tomasulo_sim* sim);
+uint32_t tomasulo_pc(const tomasulo_sim* sim);
+uint32_t tomasulo_gpr(const tomasulo_sim* sim, size_t index);
+float tomasulo_fpr(const tomasulo_sim* sim, size_t index);
+uint32_t tomasulo_memory_word(const tomasulo_sim* sim, uint32_t address);
+
+/**
+ * The trap output written so far.  The pointer is valid until the next call 
+ * with sim.
+ */
+const char* tomasulo_output(tomasulo_sim* sim);
+
+void tomasulo_on_issue(tomasulo_sim* sim, tomasulo_issue_callback callback,
+  void* context);
+void tomasulo_on_commit(tomasulo_sim* sim, tomasulo_commit_callback callback,
+  void* context);
+void tomasulo_on_retire(tomasulo_sim* sim, tomasulo_retire_callback callback,
+  void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
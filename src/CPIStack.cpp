@@ -0,0 +1,166 @@
+#include "CPIStack.h"
+#include "MachineConfig.h"
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+static const std::size_t NUM_CATEGORIES = 
+  static_cast<std::size_t>(CPICategory::Drain) + 1;
+
+static const char* categoryName(CPICategory category)
+{
+  switch (category)
+  {
+  case CPICategory::Base:
+    return "Base issue";
+  case CPICategory::Stations:
+    return "Structural stations";
+  case CPICategory::ExecuteUnits:
+    return "Structural execute units";
+  case CPICategory::DataDependence:
+    return "Data dependence";
+  case CPICategory::CDBContention:
+    return "CDB contention";
+  case CPICategory::Branch:
+    return "Branch stall";
+  case CPICategory::Drain:
+    return "Drain at halt";
+  }
+  return "";
+}
+
+CPIStack::Stack::Stack()
+  : cycles(0),
+    retired(0),
+    counts(NUM_CATEGORIES * NUM_UNIT_TYPES, 0)
+{
+}
+
+CPIStack::CPIStack(std::size_t interval)
+  : interval(interval),
+    total(),
+    current(),
+    intervals(),
+    intervalStartRetired(0)
+{
+}
+
+void CPIStack::endCycle(CPICategory category, FunctionalUnitType type,
+  Counter retired)
+{
+  auto idx = index(category, type);
+  total.counts[idx]++;
+  total.cycles++;
+  total.retired = retired;
+
+  if (interval > 0)
+  {
+    current.counts[idx]++;
+    current.cycles++;
+    current.retired = retired - intervalStartRetired;
+    if (current.cycles == interval)
+    {
+      intervals.push_back(current);
+      current = Stack();
+      intervalStartRetired = retired;
+    }
+  }
+}
+
+void CPIStack::writeReport(std::ostream& os) const
+{
+  os << std::dec << std::fixed << std::setfill(' ');
+  os << "CPI stack: " << total.cycles << " cycles, " << total.retired 
+    << " instructions, CPI " << std::setprecision(3) 
+    << ratio(static_cast<double>(total.cycles), 
+      static_cast<double>(total.retired)) << std::endl;
+  os << std::left << std::setw(36) << "Category" << std::right 
+    << std::setw(10) << "Cycles" << std::setw(9) << "Percent" 
+    << std::setw(9) << "CPI" << std::endl;
+
+  for (std::size_t c = 0; c < NUM_CATEGORIES; c++)
+  {
+    auto category = static_cast<CPICategory>(c);
+    bool perUnit = category != CPICategory::Base 
+      && category != CPICategory::Branch && category != CPICategory::Drain;
+    auto row = [&](const std::string& name, Counter cycles) {
+      os << std::left << std::setw(36) << name << std::right 
+        << std::setw(10) << cycles << std::setprecision(1) << std::setw(8)
+        << 100 * ratio(static_cast<double>(cycles), 
+          static_cast<double>(total.cycles)) << "%" 
+        << std::setprecision(3) << std::setw(9)
+        << ratio(static_cast<double>(cycles), 
+          static_cast<double>(total.retired)) << std::endl;
+    };
+
+    row(categoryName(category), sum(total, category));
+    if (perUnit)
+    {
+      for (auto type : UNIT_TYPES)
+      {
+        auto cycles = total.counts[index(category, type)];
+        if (cycles > 0)
+        {
+          std::ostringstream name;
+          name << "  " << type;
+          row(name.str(), cycles);
+        }
+      }
+    }
+  }
+
+  if (interval == 0)
+  {
+    os.unsetf(std::ios::floatfield);
+    return;
+  }
+
+  auto all = intervals;
+  if (current.cycles > 0)
+  {
+    all.push_back(current);
+  }
+
+  os << std::endl << "Intervals of " << interval << " cycles" << std::endl;
+  os << std::setw(10) << "Start" << std::setw(8) << "CPI";
+  for (std::size_t c = 0; c < NUM_CATEGORIES; c++)
+  {
+    static const char* SHORT_NAMES[] = {
+      "Base", "Stations", "ExecUnits", "DataDep", "CDB", "Branch", "Drain"
+    };
+    os << std::setw(10) << SHORT_NAMES[c];
+  }
+  os << std::endl;
+
+  std::size_t start = 1;
+  for (const auto& stack : all)
+  {
+    os << std::setw(10) << start << std::setprecision(3) << std::setw(8) 
+      << ratio(static_cast<double>(stack.cycles), 
+        static_cast<double>(stack.retired));
+    for (std::size_t c = 0; c < NUM_CATEGORIES; c++)
+    {
+      os << std::setw(10) << sum(stack, static_cast<CPICategory>(c));
+    }
+    os << std::endl;
+    start += stack.cycles;
+  }
+
+  os.unsetf(std::ios::floatfield);
+}
+
+std::size_t CPIStack::index(CPICategory category, FunctionalUnitType type)
+{
+  return static_cast<std::size_t>(category) * NUM_UNIT_TYPES 
+    + static_cast<std::size_t>(type);
+}
+
+CPIStack::Counter CPIStack::sum(const Stack& stack, CPICategory category)
+{
+  Counter result = 0;
+  for (std::size_t t = 0; t < NUM_UNIT_TYPES; t++)
+  {
+    result += stack.counts[index(category, static_cast<FunctionalUnitType>(t))];
+  }
+  return result;
+}
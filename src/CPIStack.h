@@ -0,0 +1,86 @@
+#ifndef __CPISTACK_H__
+#define __CPISTACK_H__
+
+#include "types.h"
+#include "instructions/instruction_types.h"
+#include <vector>
+#include <ostream>
+
+class CPIStack;
+using CPIStackPtr = Pointer<CPIStack>;
+
+/**
+ * What the issue stage was doing during a cycle.  When issue stalled on full 
+ * stations, the cycle is charged to the reason the unit's oldest station has 
+ * not finished.
+ */
+enum class CPICategory
+{
+  // an instruction issued
+  Base,
+  // the oldest station was executing or about to retire
+  Stations,
+  // the oldest station was ready but had no execute unit
+  ExecuteUnits,
+  // the oldest station was waiting for an operand
+  DataDependence,
+  // the oldest station lost CDB arbitration
+  CDBContention,
+  // issue waited for a branch to resolve
+  Branch,
+  // the program halted and the pipeline was draining
+  Drain
+};
+
+/**
+ * Splits the cycles of a run into CPICategory components, both for the whole 
+ * run and for fixed length intervals.
+ */
+class CPIStack
+{
+public:
+  using Counter = uint64_t;
+
+private:
+  /**
+   * Cycles per category and functional unit type.
+   */
+  struct Stack
+  {
+    Stack();
+
+    Counter cycles;
+    Counter retired;
+    std::vector<Counter> counts;
+  };
+
+  const std::size_t interval;
+  Stack total;
+  Stack current;
+  std::vector<Stack> intervals;
+  Counter intervalStartRetired;
+
+public:
+  /**
+   * Interval is the number of cycles in each interval, 0 for none.
+   */
+  explicit CPIStack(std::size_t interval);
+  CPIStack(const CPIStack&) = delete;
+  CPIStack& operator=(const CPIStack&) = delete;
+
+  /**
+   * Charges a cycle to a category.  type is the functional unit that blocked 
+   * issue, or FunctionalUnitType::None.  retired is the number of instructions 
+   * retired by the end of the cycle.
+   */
+  void endCycle(CPICategory category, FunctionalUnitType type, 
+    Counter retired);
+
+  void writeReport(std::ostream& os) const;
+
+private:
+  static std::size_t index(CPICategory category, FunctionalUnitType type);
+  static Counter sum(const Stack& stack, CPICategory category);
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include "CoSimulation.h"
+#include "MachineConfig.h"
+#include "Exceptions.h"
+#include "log.h"
+#include "utility/stream_manip.h"
+#include <sstream>
+#include <cassert>
+
+static const std::string TAG = "CoSimulation";
+
+/**
+ * Formats a register value as hex, with the float it holds for FPRs.
+ */
+static std::string formatValue(const RegisterID& reg, Data value)
+{
+  std::ostringstream os;
+  os << reg << "=" << util::hex<UWord> << value.uw;
+  if (reg.type == RegisterType::FPR)
+  {
+    os << " (" << value.f << ")";
+  }
+  return os.str();
+}
+
+/**
+ * Formats a store as its address and value.
+ */
+static std::string formatStore(Address addr, UWord value)
+{
+  std::ostringstream os;
+  os << "[" << util::hex<Address> << addr << "]=" << util::hex<UWord> 
+    << value;
+  return os.str();
+}
+
+CoSimulation::CoSimulation(const Memory& image, Address entryPoint)
+  : discard(nullptr),
+    memory(image.copy()),
+    model(memory, entryPoint, discard),
+    clock(0),
+    expected(),
+    registerChecks(0),
+    storeChecks(0)
+{
+}
+
+uint64_t CoSimulation::instructions() const
+{
+  return model.instructions();
+}
+
+uint64_t CoSimulation::registerWritesChecked() const
+{
+  return registerChecks;
+}
+
+uint64_t CoSimulation::storesChecked() const
+{
+  return storeChecks;
+}
+
+void CoSimulation::setClock(std::size_t clock)
+{
+  this->clock = clock;
+}
+
+void CoSimulation::issue(const ReservationStationID& station, 
+  InstructionPtr instruction)
+{
+  assert(instruction);
+
+  TraceRecord record;
+  auto pc = model.getPC();
+  if (model.isHalted() || !model.step(record) || model.isHalted())
+  {
+    std::ostringstream os;
+    os << "halt at " << util::hex<Address> << pc;
+    std::ostringstream actual;
+    actual << *instruction << " at " << util::hex<Address> 
+      << instruction->getAddress();
+    diverge("Issued an instruction after the program halted", station, 
+      nullptr, os.str(), actual.str());
+  }
+  if (record.address != instruction->getAddress())
+  {
+    std::ostringstream os;
+    os << util::hex<Address> << record.address;
+    std::ostringstream actual;
+    actual << *instruction << " at " << util::hex<Address> 
+      << instruction->getAddress();
+    diverge("Issued from the wrong address", station, nullptr, os.str(), 
+      actual.str());
+  }
+
+  expected[station] = Expected{ instruction, model.instructions(), clock,
+    model.lastEffect() };
+}
+
+void CoSimulation::halt(Address pc)
+{
+  TraceRecord record;
+  auto modelPC = model.getPC();
+  if (model.isHalted() || !model.step(record) || !model.isHalted())
+  {
+    std::ostringstream os;
+    os << "instruction at " << util::hex<Address> << modelPC;
+    std::ostringstream actual;
+    actual << "halt at " << util::hex<Address> << pc;
+    diverge("Halted before the program did", ReservationStationID::NONE, 
+      nullptr, os.str(), actual.str());
+  }
+  if (modelPC != pc)
+  {
+    std::ostringstream os;
+    os << "halt at " << util::hex<Address> << modelPC;
+    std::ostringstream actual;
+    actual << "halt at " << util::hex<Address> << pc;
+    diverge("Halted at the wrong address", ReservationStationID::NONE, 
+      nullptr, os.str(), actual.str());
+  }
+}
+
+void CoSimulation::registerWrite(const ReservationStationID& station,
+  const RegisterID& dest, Data value)
+{
+  auto& instr = expectedOf(station);
+  registerChecks++;
+  if (instr.effect.dest != dest || instr.effect.value.uw != value.uw)
+  {
+    diverge("Register write differs", station, &instr,
+      instr.effect.dest == RegisterID::NONE ? "no register write" 
+        : formatValue(instr.effect.dest, instr.effect.value),
+      formatValue(dest, value));
+  }
+}
+
+void CoSimulation::store(const ReservationStationID& station, Address addr,
+  UWord value)
+{
+  auto& instr = expectedOf(station);
+  storeChecks++;
+  if (!instr.effect.store || instr.effect.storeAddress != addr 
+    || instr.effect.storeValue != value)
+  {
+    diverge("Store differs", station, &instr,
+      !instr.effect.store ? "no store" 
+        : formatStore(instr.effect.storeAddress, instr.effect.storeValue),
+      formatStore(addr, value));
+  }
+}
+
+void CoSimulation::finish(const RegisterFile& registers)
+{
+  for (std::size_t i = 0; i < GPR_REGISTERS + FPR_REGISTERS; i++)
+  {
+    auto reg = registerAt(i);
+    auto expectedValue = model.getRegisters().read(reg);
+    auto actualValue = registers.read(reg);
+    if (expectedValue.uw != actualValue.uw)
+    {
+      diverge("Final register file differs", ReservationStationID::NONE,
+        nullptr, formatValue(reg, expectedValue), 
+        formatValue(reg, actualValue));
+    }
+  }
+
+  logger->info(TAG) << "Checked " << model.instructions() 
+    << " instructions, " << registerChecks << " register writes and " 
+    << storeChecks << " stores";
+}
+
+const CoSimulation::Expected& CoSimulation::expectedOf(
+  const ReservationStationID& station) const
+{
+  auto it = expected.find(station);
+  if (it == expected.end())
+  {
+    diverge("Result from a station that was never issued", station, nullptr,
+      "none", "a result");
+  }
+  return it->second;
+}
+
+void CoSimulation::diverge(const std::string& what, 
+  const ReservationStationID& station, const Expected* instruction,
+  const std::string& expectedValue, const std::string& actualValue) const
+{
+  std::ostringstream os;
+  os << "Diverged from the functional model: " << what << "\n"
+    << "  cycle:       " << clock << "\n"
+    << "  model:       " << model.instructions() << " instructions "
+    << "executed\n";
+  if (station != ReservationStationID::NONE)
+  {
+    os << "  station:     " << station << "\n";
+  }
+  if (instruction)
+  {
+    os << "  instruction: #" << instruction->sequence << " " 
+      << *instruction->instruction << " at " << util::hex<Address> 
+      << instruction->instruction->getAddress() << ", issued in cycle " 
+      << std::dec << instruction->issueClock << "\n";
+  }
+  os << "  expected:    " << expectedValue << "\n"
+    << "  actual:      " << actualValue;
+
+  logger->error(TAG) << os.str();
+  throw DivergenceException(os.str());
+}
@@ -0,0 +1,97 @@
+#ifndef __COSIMULATION_H__
+#define __COSIMULATION_H__
+
+#include "types.h"
+#include "Memory.h"
+#include "RegisterFile.h"
+#include "ReservationStationID.h"
+#include "FunctionalModel.h"
+#include "instructions/Instruction.h"
+#include <unordered_map>
+#include <ostream>
+#include <string>
+
+class CoSimulation;
+using CoSimulationPtr = Pointer<CoSimulation>;
+
+/**
+ * Runs a FunctionalModel in lockstep with Tomasulo, stepping it as each 
+ * instruction issues and checking every register write on the CDB and every 
+ * store against what the model computed.  The first difference throws a 
+ * DivergenceException describing it.
+ */
+class CoSimulation
+{
+private:
+  /**
+   * What the model computed for the instruction held by a station.
+   */
+  struct Expected
+  {
+    InstructionPtr instruction;
+    uint64_t sequence;
+    std::size_t issueClock;
+    FunctionalEffect effect;
+  };
+
+  std::ostream discard;
+  MemoryPtr memory;
+  FunctionalModel model;
+  std::size_t clock;
+  std::unordered_map<ReservationStationID, Expected, ReservationStationIDHash>
+    expected;
+  uint64_t registerChecks;
+  uint64_t storeChecks;
+
+public:
+  /**
+   * The model runs on its own copy of image, from entryPoint.
+   */
+  CoSimulation(const Memory& image, Address entryPoint);
+  CoSimulation(const CoSimulation&) = delete;
+  CoSimulation& operator=(const CoSimulation&) = delete;
+
+  uint64_t instructions() const;
+  uint64_t registerWritesChecked() const;
+  uint64_t storesChecked() const;
+
+  /**
+   * Sets the cycle reported with a divergence.
+   */
+  void setClock(std::size_t clock);
+
+  /**
+   * Steps the model past the instruction issued to station.
+   */
+  void issue(const ReservationStationID& station, InstructionPtr instruction);
+
+  /**
+   * Checks that the model also halts at pc.
+   */
+  void halt(Address pc);
+
+  /**
+   * Checks a value written to the register file by the instruction in 
+   * station.
+   */
+  void registerWrite(const ReservationStationID& station, 
+    const RegisterID& dest, Data value);
+
+  /**
+   * Checks a value written to memory by the instruction in station.
+   */
+  void store(const ReservationStationID& station, Address addr, UWord value);
+
+  /**
+   * Checks the register file once every instruction has completed.
+   */
+  void finish(const RegisterFile& registers);
+
+private:
+  const Expected& expectedOf(const ReservationStationID& station) const;
+  void diverge(const std::string& what, const ReservationStationID& station,
+    const Expected* instruction, const std::string& expectedValue, 
+    const std::string& actualValue) const;
+};
+
+#endif
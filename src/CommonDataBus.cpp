@@ -10,20 +10,27 @@
 static const std::string TAG = "CommonDataBus";
 
 CommonDataBus::CommonDataBus(RegisterFilePtr registers,
-  RenameRegisterFilePtr renameRegisters)
+  RenameRegisterFilePtr renameRegisters, PerformanceCountersPtr counters)
   : used(false),
     idleThisCycle(true),
+    dumpedIdle(true),
     source(nullptr),
     sourceID(ReservationStationID::NONE),
     destID(RegisterID::NONE),
     value(),
     registers(registers),
     renameRegisters(renameRegisters),
+    counters(counters),
+    coSimulation(nullptr),
+    events(nullptr),
+    fastForward(nullptr),
     listeners(),
+    numListeners(0),
     rejected()
 {
   assert(registers != nullptr);
   assert(renameRegisters != nullptr);
+  assert(counters != nullptr);
 }
 
 void CommonDataBus::write(ReservationStation* src)
@@ -54,6 +61,11 @@ void CommonDataBus::write(ReservationStation* src)
 
 void CommonDataBus::commit()
 {
+  if (counters->occupancy)
+  {
+    counters->occupancy->cdbRequests.add(used ? rejected.size() + 1 : 0);
+  }
+
   if (used)
   {
     sourceID = source->getID();
@@ -67,10 +79,28 @@ void CommonDataBus::commit()
     for (auto rs : rejected)
     {
       logger->debug(TAG) << rs->getID() << " could not write";
+      if (counters->pcProfile)
+      {
+        counters->pcProfile->at(rs->getAddress()).cdbWaitCycles++;
+      }
     }
+    counters->cdbGrants++;
+    counters->cdbRejections += rejected.size();
     rejected.clear();
 
     notifyListeners();
+    if (coSimulation)
+    {
+      coSimulation->registerWrite(sourceID, destID, value);
+    }
+    if (events && events->commit)
+    {
+      events->commit(sourceID, destID, value);
+    }
+    if (fastForward)
+    {
+      fastForward->registerWrite(destID);
+    }
     registers->write(destID, value);
 
     logger->debug(TAG) << "Committed " << destID << "="
@@ -82,33 +112,109 @@ void CommonDataBus::commit()
   {
     idleThisCycle = true;
   }
+
+  if (counters->occupancy)
+  {
+    counters->occupancy->cdbListeners.add(numListeners);
+  }
+}
+
+void CommonDataBus::reset()
+{
+  used = false;
+  idleThisCycle = true;
+  dumpedIdle = true;
+  source = nullptr;
+  sourceID = ReservationStationID::NONE;
+  destID = RegisterID::NONE;
+  value = Data();
+  coSimulation = nullptr;
+  events = nullptr;
+  fastForward = nullptr;
+  // the lists are kept so they do not have to grow again
+  for (auto& type : listeners)
+  {
+    for (auto& station : type)
+    {
+      station.clear();
+    }
+  }
+  numListeners = 0;
+  rejected.clear();
+}
+
+void CommonDataBus::setCoSimulation(CoSimulationPtr coSimulation)
+{
+  this->coSimulation = coSimulation;
+}
+
+void CommonDataBus::setEvents(SimulationEventsPtr events)
+{
+  this->events = events;
 }
 
-void CommonDataBus::dumpState() const
+void CommonDataBus::setFastForward(FastForwardPtr fastForward)
 {
-  std::cout << "CDB: ";
+  this->fastForward = fastForward;
+}
+
+void CommonDataBus::dumpState(std::ostream& os) const
+{
+  os << "CDB: ";
   if (idleThisCycle)
   {
-    std::cout << "Empty" << std::endl;
+    os << "Empty" << std::endl;
   }
   else
   {
-    std::cout << sourceID << "=" << util::hex<UWord> << value.uw
+    os << sourceID << "=" << util::hex<UWord> << value.uw
       << std::endl;
   }
 }
 
-void CommonDataBus::addListener(ReservationStation* rs)
+void CommonDataBus::dumpChanges(bool full)
+{
+  if (full || !idleThisCycle || !dumpedIdle)
+  {
+    dumpState();
+  }
+  dumpedIdle = idleThisCycle;
+}
+
+void CommonDataBus::addListener(ReservationStation* rs,
+  const ReservationStationID& source)
 {
   assert(rs != nullptr);
-  listeners.push_back(rs);
+  assert(source != ReservationStationID::NONE);
+  listenersOf(source).push_back(rs);
+  numListeners++;
 }
 
 void CommonDataBus::notifyListeners()
 {
-  auto pred = [&](ReservationStation* rs) {
-    return rs->notifyDataBus(sourceID, value);
-  };
-  listeners.remove_if(pred);
+  // every station waiting on the source captures the value now, so the list 
+  // is emptied (keeping its capacity for the source's next instruction)
+  auto& waiting = listenersOf(sourceID);
+  for (auto rs : waiting)
+  {
+    rs->notifyDataBus(sourceID, value);
+  }
+  numListeners -= waiting.size();
+  waiting.clear();
 }
 
+std::vector<ReservationStation*>& CommonDataBus::listenersOf(
+  const ReservationStationID& source)
+{
+  auto type = static_cast<std::size_t>(source.type);
+  if (type >= listeners.size())
+  {
+    listeners.resize(type + 1);
+  }
+  if (source.index >= listeners[type].size())
+  {
+    listeners[type].resize(source.index + 1);
+  }
+
+  return listeners[type][source.index];
+}
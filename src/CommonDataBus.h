@@ -6,7 +6,12 @@
 #include "ReservationStationID.h"
 #include "RegisterFile.h"
 #include "RenameRegisterFile.h"
-#include <list>
+#include "PerformanceCounters.h"
+#include "CoSimulation.h"
+#include "SimulationEvents.h"
+#include "FastForward.h"
+#include <vector>
+#include <iostream>
 
 class CommonDataBus;
 using CommonDataBusPtr = Pointer<CommonDataBus>;
@@ -16,18 +21,26 @@ class CommonDataBus
 private:
   bool used;
   bool idleThisCycle;
+  bool dumpedIdle;
   ReservationStation* source;
   ReservationStationID sourceID;
   RegisterID destID;
   Data value;
   RegisterFilePtr registers;
   RenameRegisterFilePtr renameRegisters;
-  std::list<ReservationStation*> listeners;
-  std::list<ReservationStation*> rejected;
+  PerformanceCountersPtr counters;
+  CoSimulationPtr coSimulation;
+  SimulationEventsPtr events;
+  FastForwardPtr fastForward;
+  // stations waiting on each producer, indexed by producer type then index
+  std::vector<std::vector<std::vector<ReservationStation*>>> listeners;
+  // total registrations in listeners
+  std::size_t numListeners;
+  std::vector<ReservationStation*> rejected;
 
 public:
   explicit CommonDataBus(RegisterFilePtr registers,
-    RenameRegisterFilePtr renameRegisters);
+    RenameRegisterFilePtr renameRegisters, PerformanceCountersPtr counters);
   CommonDataBus& operator=(CommonDataBus&) = delete;
 
   /**
@@ -40,17 +53,51 @@ public:
 
   /**
    * If a value was written to the CDB, notifies the source that its write was 
-   * accepted, notifies all listeners of the written value and its source, then 
-   * commits the value to the register file.
+   * accepted, notifies the listeners waiting on the source of the written 
+   * value, then commits the value to the register file.
    */
   void commit();
 
-  void dumpState() const;
+  /**
+   * Returns to the state after construction: nothing written, no listeners 
+   * and no coSimulation, events or fastForward.
+   */
+  void reset();
+
+  /**
+   * Checks every value committed to the register file against coSimulation 
+   * when it is set.
+   */
+  void setCoSimulation(CoSimulationPtr coSimulation);
 
-  void addListener(ReservationStation* rs);
+  /**
+   * Reports every value committed to the register file to events.
+   */
+  void setEvents(SimulationEventsPtr events);
+
+  /**
+   * Reports every value committed to the register file to fastForward.
+   */
+  void setFastForward(FastForwardPtr fastForward);
+
+  void dumpState(std::ostream& os = std::cout) const;
+
+  /**
+   * Prints the CDB state unless it was idle both this cycle and at the last 
+   * call.  Always prints when full is set.
+   */
+  void dumpChanges(bool full);
+
+  /**
+   * Registers rs to be notified when source writes its result.  A station 
+   * waiting on two different sources registers once for each.
+   */
+  void addListener(ReservationStation* rs, const ReservationStationID& source);
 
 private:
   void notifyListeners();
+  std::vector<ReservationStation*>& listenersOf(
+    const ReservationStationID& source);
 };
 
 #endif
@@ -0,0 +1,318 @@
+#include "Dataflow.h"
+#include "MachineConfig.h"
+#include "utility/stream_manip.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iomanip>
+
+// identifies a dataflow log
+static const char HEADER[8] = { 'T', 'D', 'F', 'L', 'O', 'G', '0', '1' };
+// records read or written at a time
+static const std::size_t CHUNK_RECORDS = 4096;
+static const std::size_t NUM_STATION_CODES = NUM_UNIT_TYPES << 8;
+static const std::size_t NUM_REGISTER_CODES = 2 << 6;
+static const uint64_t UNBOUNDED = ~0ull;
+
+static uint16_t stationCode(const ReservationStationID& id)
+{
+  assert(id.index < 256);
+  return static_cast<uint16_t>(
+    static_cast<std::size_t>(id.type) << 8 | id.index);
+}
+
+static uint8_t registerCode(const RegisterID& reg)
+{
+  assert(reg.index < 64);
+  return static_cast<uint8_t>(
+    static_cast<std::size_t>(reg.type) << 6 | reg.index);
+}
+
+static uint16_t sourceCode(const RegisterID& reg, 
+  const ReservationStationID& source)
+{
+  if (reg == RegisterID::NONE)
+  {
+    return DataflowRecord::NO_SOURCE;
+  }
+  if (source != ReservationStationID::NONE)
+  {
+    return DataflowRecord::STATION_SOURCE | stationCode(source);
+  }
+  return registerCode(reg);
+}
+
+static std::string trim(const std::string& str)
+{
+  auto first = str.find_first_not_of(" \t");
+  if (first == std::string::npos)
+  {
+    return "";
+  }
+  return str.substr(first, str.find_last_not_of(" \t") - first + 1);
+}
+
+DataflowLog::DataflowLog(const std::string& filename)
+  : file(filename.c_str(), std::ios::out | std::ios::binary),
+    buffer()
+{
+  buffer.reserve(CHUNK_RECORDS);
+  file.write(HEADER, sizeof(HEADER));
+}
+
+DataflowLog::~DataflowLog()
+{
+  close();
+}
+
+bool DataflowLog::good() const
+{
+  return static_cast<bool>(file);
+}
+
+void DataflowLog::issue(const ReservationStationID& station, 
+  const Instruction& instruction, std::size_t latency, 
+  const ReservationStationID& arg1Source, 
+  const ReservationStationID& arg2Source)
+{
+  DataflowRecord record;
+  std::memset(&record, 0, sizeof(record));
+  record.address = instruction.getAddress();
+  record.latency = static_cast<uint16_t>(latency);
+  record.station = stationCode(station);
+  record.sources[0] = sourceCode(instruction.getArg1(), arg1Source);
+  record.sources[1] = sourceCode(instruction.getArg2(), arg2Source);
+  auto dest = instruction.getDest();
+  record.dest = dest == RegisterID::NONE || dest == RegisterID::R0 
+    ? DataflowRecord::NO_DEST : registerCode(dest);
+
+  buffer.push_back(record);
+  if (buffer.size() == CHUNK_RECORDS)
+  {
+    flush();
+  }
+}
+
+bool DataflowLog::close()
+{
+  if (file.is_open())
+  {
+    flush();
+    file.close();
+    return !file.fail();
+  }
+  return true;
+}
+
+void DataflowLog::flush()
+{
+  file.write(reinterpret_cast<const char*>(buffer.data()), 
+    buffer.size() * sizeof(DataflowRecord));
+  buffer.clear();
+}
+
+DataflowAnalysis::DataflowAnalysis()
+  : instructions(0),
+    pathLength(0),
+    addresses()
+{
+}
+
+bool DataflowAnalysis::analyze(const std::string& filename)
+{
+  std::fstream file(filename.c_str(), 
+    std::ios::in | std::ios::out | std::ios::binary);
+  char header[sizeof(HEADER)];
+  if (!file.read(header, sizeof(header)) 
+    || std::memcmp(header, HEADER, sizeof(HEADER)) != 0)
+  {
+    return false;
+  }
+
+  instructions = 0;
+  pathLength = 0;
+  addresses.clear();
+  return forwardPass(file) && backwardPass(file);
+}
+
+DataflowAnalysis::Counter DataflowAnalysis::criticalPathLength() const
+{
+  return pathLength;
+}
+
+double DataflowAnalysis::idealILP() const
+{
+  return ratio(static_cast<double>(instructions), 
+    static_cast<double>(pathLength));
+}
+
+void DataflowAnalysis::writeReport(std::ostream& os, 
+  const SourceListing& source, Counter cycles, std::size_t numHottest) const
+{
+  auto ipc = ratio(static_cast<double>(instructions), 
+    static_cast<double>(cycles));
+  os << std::dec << std::fixed << std::setfill(' ') << std::setprecision(3);
+  os << "Dataflow analysis of " << instructions << " instructions" 
+    << std::endl;
+  os << "Critical path: " << pathLength << " cycles of execute latency" 
+    << std::endl;
+  os << "Ideal ILP: " << idealILP() << std::endl;
+  os << "Achieved IPC: " << ipc << " in " << cycles << " cycles (" 
+    << std::setprecision(1) << 100 * ratio(ipc, idealILP()) 
+    << "% of ideal)" << std::endl;
+  os << "A run close to the ideal is limited by latency, one far below it by "
+    << "stations, execute units, the CDB or issue" << std::endl;
+
+  std::vector<std::pair<Address, AddressCounters>> hottest;
+  for (const auto& entry : addresses)
+  {
+    if (entry.second.critical > 0)
+    {
+      hottest.push_back(entry);
+    }
+  }
+  std::stable_sort(hottest.begin(), hottest.end(), 
+    [](const std::pair<Address, AddressCounters>& lhs,
+      const std::pair<Address, AddressCounters>& rhs) {
+      return lhs.second.critical > rhs.second.critical;
+    });
+  if (hottest.size() > numHottest)
+  {
+    hottest.resize(numHottest);
+  }
+
+  os << std::endl << "Addresses most often on the critical path" << std::endl;
+  os << "Address   Critical  Executed  Percent  Source" << std::endl;
+  for (const auto& entry : hottest)
+  {
+    auto line = source.find(entry.first);
+    os << util::hex<Address> << entry.first << std::dec << std::setfill(' ')
+      << " " << std::setw(9) << entry.second.critical
+      << " " << std::setw(9) << entry.second.executed
+      << " " << std::setw(7) << 100 * ratio(
+        static_cast<double>(entry.second.critical), 
+        static_cast<double>(entry.second.executed)) << "%"
+      << "  " << (line == source.end() ? "" : trim(line->second)) 
+      << std::endl;
+  }
+
+  os.unsetf(std::ios::floatfield);
+}
+
+bool DataflowAnalysis::forwardPass(std::fstream& file)
+{
+  // the finish of the last instruction issued to each station, and of the 
+  // last instruction issued that writes each register
+  std::vector<uint64_t> stationFinish(NUM_STATION_CODES, 0);
+  std::vector<uint64_t> registerFinish(NUM_REGISTER_CODES, 0);
+  std::vector<DataflowRecord> chunk(CHUNK_RECORDS);
+
+  std::streamoff pos = sizeof(HEADER);
+  while (true)
+  {
+    file.seekg(pos);
+    file.read(reinterpret_cast<char*>(chunk.data()), 
+      chunk.size() * sizeof(DataflowRecord));
+    auto count = static_cast<std::size_t>(file.gcount()) 
+      / sizeof(DataflowRecord);
+    file.clear();
+    if (count == 0)
+    {
+      break;
+    }
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+      auto& record = chunk[i];
+      uint64_t ready = 0;
+      for (auto src : record.sources)
+      {
+        if (src == DataflowRecord::NO_SOURCE)
+        {
+          continue;
+        }
+        ready = std::max(ready, (src & DataflowRecord::STATION_SOURCE)
+          ? stationFinish[src & ~DataflowRecord::STATION_SOURCE]
+          : registerFinish[src]);
+      }
+
+      record.finish = ready + record.latency;
+      stationFinish[record.station] = record.finish;
+      if (record.dest != DataflowRecord::NO_DEST)
+      {
+        registerFinish[record.dest] = record.finish;
+      }
+      pathLength = std::max(pathLength, record.finish);
+      addresses[record.address].executed++;
+    }
+    instructions += count;
+
+    file.seekp(pos);
+    file.write(reinterpret_cast<const char*>(chunk.data()), 
+      count * sizeof(DataflowRecord));
+    if (!file)
+    {
+      return false;
+    }
+    pos += count * sizeof(DataflowRecord);
+  }
+
+  return true;
+}
+
+bool DataflowAnalysis::backwardPass(std::fstream& file)
+{
+  // the latest finish allowed by the consumers seen so far of the previous 
+  // instruction issued to each station, and of the previous writer of each 
+  // register
+  std::vector<uint64_t> stationRequired(NUM_STATION_CODES, UNBOUNDED);
+  std::vector<uint64_t> registerRequired(NUM_REGISTER_CODES, UNBOUNDED);
+  std::vector<DataflowRecord> chunk(CHUNK_RECORDS);
+
+  uint64_t end = instructions;
+  while (end > 0)
+  {
+    auto begin = end > CHUNK_RECORDS ? end - CHUNK_RECORDS : 0;
+    auto count = static_cast<std::size_t>(end - begin);
+    file.seekg(static_cast<std::streamoff>(
+      sizeof(HEADER) + begin * sizeof(DataflowRecord)));
+    if (!file.read(reinterpret_cast<char*>(chunk.data()), 
+      count * sizeof(DataflowRecord)))
+    {
+      return false;
+    }
+
+    for (std::size_t i = count; i > 0; i--)
+    {
+      const auto& record = chunk[i - 1];
+      auto latest = std::min(pathLength, stationRequired[record.station]);
+      stationRequired[record.station] = UNBOUNDED;
+      if (record.dest != DataflowRecord::NO_DEST)
+      {
+        latest = std::min(latest, registerRequired[record.dest]);
+        registerRequired[record.dest] = UNBOUNDED;
+      }
+
+      if (latest == record.finish)
+      {
+        addresses[record.address].critical++;
+      }
+
+      auto start = latest - record.latency;
+      for (auto src : record.sources)
+      {
+        if (src == DataflowRecord::NO_SOURCE)
+        {
+          continue;
+        }
+        auto& required = (src & DataflowRecord::STATION_SOURCE)
+          ? stationRequired[src & ~DataflowRecord::STATION_SOURCE]
+          : registerRequired[src];
+        required = std::min(required, start);
+      }
+    }
+    end = begin;
+  }
+
+  return true;
+}
@@ -0,0 +1,129 @@
+#ifndef __DATAFLOW_H__
+#define __DATAFLOW_H__
+
+#include "types.h"
+#include "ReservationStationID.h"
+#include "PCProfile.h"
+#include "instructions/Instruction.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <ostream>
+
+class DataflowLog;
+using DataflowLogPtr = Pointer<DataflowLog>;
+
+/**
+ * One issued instruction in a DataflowLog, stored in host byte order.  Each 
+ * source is either the station producing it (the tag captured at issue), or 
+ * the register it was read from because no station was producing it.
+ */
+struct DataflowRecord
+{
+  static const uint16_t NO_SOURCE = 0xffff;
+  // set in a source that is a station code
+  static const uint16_t STATION_SOURCE = 0x8000;
+  static const uint8_t NO_DEST = 0xff;
+
+  Address address;
+  uint16_t latency;
+  // FunctionalUnitType << 8 | station index
+  uint16_t station;
+  uint16_t sources[2];
+  // RegisterType << 6 | register index
+  uint8_t dest;
+  uint8_t padding[3];
+  // the earliest cycle the result could be ready, filled in by analysis
+  uint64_t finish;
+};
+
+/**
+ * Streams a DataflowRecord for every instruction issued to a file, for 
+ * analysis after the run.
+ */
+class DataflowLog
+{
+private:
+  std::ofstream file;
+  std::vector<DataflowRecord> buffer;
+
+public:
+  explicit DataflowLog(const std::string& filename);
+  DataflowLog(const DataflowLog&) = delete;
+  DataflowLog& operator=(const DataflowLog&) = delete;
+  ~DataflowLog();
+
+  bool good() const;
+
+  /**
+   * Records an instruction issued to station, with the sources set by the 
+   * station at issue (ReservationStationID::NONE if read from a register).
+   */
+  void issue(const ReservationStationID& station, 
+    const Instruction& instruction, std::size_t latency, 
+    const ReservationStationID& arg1Source, 
+    const ReservationStationID& arg2Source);
+
+  /**
+   * Writes the buffered records.  Returns false if the file could not be 
+   * written.
+   */
+  bool close();
+
+private:
+  void flush();
+};
+
+/**
+ * Finds the dataflow critical path of a DataflowLog: the longest chain of 
+ * execute latencies through register dependences, which is the run time of 
+ * an ideal machine with unlimited stations, execute units and CDB bandwidth.  
+ * The log is streamed twice, forward to compute the earliest finish of each 
+ * instruction and backward to find the instructions with no slack, so memory 
+ * use does not grow with the length of the run.
+ */
+class DataflowAnalysis
+{
+public:
+  using Counter = uint64_t;
+
+private:
+  /**
+   * The dynamic instructions at one address.
+   */
+  struct AddressCounters
+  {
+    Counter executed;
+    Counter critical;
+  };
+
+  Counter instructions;
+  Counter pathLength;
+  std::map<Address, AddressCounters> addresses;
+
+public:
+  DataflowAnalysis();
+
+  /**
+   * Analyzes a log written by DataflowLog.  Earliest finish times are stored 
+   * in the log.  Returns false if the log could not be read or written.
+   */
+  bool analyze(const std::string& filename);
+
+  Counter criticalPathLength() const;
+  double idealILP() const;
+
+  /**
+   * Compares the ideal ILP with the IPC achieved in cycles, and lists the 
+   * numHottest addresses most often on the critical path.
+   */
+  void writeReport(std::ostream& os, const SourceListing& source, 
+    Counter cycles, std::size_t numHottest) const;
+
+private:
+  bool forwardPass(std::fstream& file);
+  bool backwardPass(std::fstream& file);
+};
+
+#endif
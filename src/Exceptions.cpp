@@ -30,3 +30,8 @@ InvalidRegisterException::InvalidRegisterException(const RegisterID& reg)
   os << "Unknown register access: " << reg;
   msg = os.str();
 }
+
+DivergenceException::DivergenceException(const std::string& msg)
+  : Exception(msg)
+{
+}
@@ -60,4 +60,14 @@ public:
   InvalidRegisterException(const RegisterID& reg);
 };
 
+/**
+ * Signals that the processor's results differ from the functional model's.
+ */
+class DivergenceException
+  : public Exception
+{
+public:
+  explicit DivergenceException(const std::string& msg);
+};
+
 #endif
@@ -0,0 +1,315 @@
+#include "FastForward.h"
+#include "FunctionalUnit.h"
+#include "MachineConfig.h"
+#include "Exceptions.h"
+#include "log.h"
+#include "utility/stream_manip.h"
+#include <algorithm>
+#include <cassert>
+
+static const std::string TAG = "FastForward";
+
+// issued instructions remembered, which bounds the length of a loop
+static const std::size_t HISTORY_LIMIT = 1 << 16;
+
+FastForward::FastForward(MemoryPtr memory, RegisterFilePtr registers,
+  RenameRegisterFilePtr renameRegisters, PerformanceCountersPtr counters,
+  Address entryPoint)
+  : discard(nullptr),
+    modelMemory(memory->copy()),
+    model(modelMemory, entryPoint, discard),
+    memory(memory),
+    registers(registers),
+    renameRegisters(renameRegisters),
+    counters(counters),
+    units(),
+    enabled(true),
+    lastPC(entryPoint),
+    issued(0),
+    traps(0),
+    staleWrites(0),
+    history(),
+    historyStart(0),
+    inFlight(),
+    candidates(),
+    signature(),
+    iteration(),
+    lastIteration(),
+    loops(0),
+    iterations(0),
+    cycles(0)
+{
+}
+
+void FastForward::addFunctionalUnit(Pointer<FunctionalUnit> unit)
+{
+  units.push_back(unit);
+}
+
+uint64_t FastForward::loopsSkipped() const
+{
+  return loops;
+}
+
+uint64_t FastForward::iterationsSkipped() const
+{
+  return iterations;
+}
+
+uint64_t FastForward::cyclesSkipped() const
+{
+  return cycles;
+}
+
+void FastForward::issue(const ReservationStationID& station,
+  const Instruction& instruction)
+{
+  auto& held = inFlight[station];
+  held.sequence = issued++;
+  held.store = instruction.getWriteAction() == WriteAction::Memory;
+  if (instruction.getType() == FunctionalUnitType::Trap)
+  {
+    traps++;
+  }
+  if (!enabled)
+  {
+    return;
+  }
+
+  TraceRecord record;
+  try
+  {
+    model.step(record);
+  }
+  catch (const Exception& e)
+  {
+    disable(e.what());
+    return;
+  }
+  if (record.address != instruction.getAddress())
+  {
+    disable("the model is at a different address");
+    return;
+  }
+  history.push_back(Issued{ record.address, record.instruction });
+}
+
+void FastForward::registerWrite(const RegisterID& dest)
+{
+  // the writer is still renamed unless a younger instruction already wrote
+  // the register, in which case the register file now holds an older value
+  // than the model
+  if (dest != RegisterID::R0
+    && renameRegisters->getRenaming(dest) == ReservationStationID::NONE)
+  {
+    staleWrites++;
+  }
+}
+
+std::size_t FastForward::endCycle(std::size_t clock, Address pc,
+  bool stallIssue, std::size_t maxCycles)
+{
+  bool backwards = pc < lastPC;
+  lastPC = pc;
+  if (!enabled || stallIssue || !backwards)
+  {
+    return 0;
+  }
+
+  if (history.size() > HISTORY_LIMIT)
+  {
+    clearHistory();
+  }
+
+  writeSignature(clock);
+  auto found = candidates.find(pc);
+  if (found != candidates.end())
+  {
+    const auto& start = found->second;
+    if (start.issued >= historyStart && start.issued < issued
+      && start.traps == traps && start.staleWrites == staleWrites
+      && start.signature == signature)
+    {
+      auto skipped = skip(start, clock, pc, maxCycles);
+      if (skipped > 0)
+      {
+        clearHistory();
+        return skipped;
+      }
+    }
+  }
+
+  auto& candidate = candidates[pc];
+  candidate.signature.swap(signature);
+  candidate.counters = counters->snapshot();
+  candidate.clock = clock;
+  candidate.issued = issued;
+  candidate.traps = traps;
+  candidate.staleWrites = staleWrites;
+  return 0;
+}
+
+void FastForward::writeSignature(std::size_t clock)
+{
+  signature.clear();
+  for (const auto& unit : units)
+  {
+    unit->writeSignature(clock, signature);
+  }
+  renameRegisters->writeSignature(signature);
+}
+
+std::size_t FastForward::skip(const Candidate& start, std::size_t clock,
+  Address pc, std::size_t maxCycles)
+{
+  auto period = clock - start.clock;
+  auto length = static_cast<std::size_t>(issued - start.issued);
+
+  // every instruction in flight must have issued during the period, so its
+  // instance whole periods later is in the model's last iteration
+  struct Held
+  {
+    uint64_t sequence;
+    InFlight* held;
+    ReservationStation* station;
+  };
+  std::vector<Held> held;
+  for (const auto& unit : units)
+  {
+    for (std::size_t i = 0; i < unit->numStations(); i++)
+    {
+      auto& station = unit->getStation(i);
+      if (station.getState() == ReservationStationState::Idle)
+      {
+        continue;
+      }
+      auto& entry = inFlight[station.getID()];
+      if (entry.sequence < start.issued)
+      {
+        return 0;
+      }
+      held.push_back(Held{ entry.sequence, &entry, &station });
+    }
+  }
+
+  std::vector<Data> before(GPR_REGISTERS + FPR_REGISTERS);
+  for (std::size_t i = 0; i < before.size(); i++)
+  {
+    before[i] = model.getRegisters().read(registerAt(i));
+  }
+
+  auto path = &history[static_cast<std::size_t>(start.issued - historyStart)];
+  auto maxIterations = maxCycles / period;
+  uint64_t count = 0;
+  while (count < maxIterations && runIteration(path, length))
+  {
+    iteration.swap(lastIteration);
+    count++;
+  }
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  auto skippedCycles = static_cast<std::size_t>(count * period);
+  auto skippedInstructions = count * length;
+  counters->advance(start.counters, counters->snapshot(), count);
+
+  // the model's memory has every issued store, so the stores still in flight
+  // are undone, youngest first
+  memory->write(0, modelMemory->snapshot());
+  std::sort(held.begin(), held.end(), [](const Held& a, const Held& b) {
+    return a.sequence > b.sequence;
+  });
+  for (const auto& entry : held)
+  {
+    const auto& effect = lastIteration[entry.sequence - start.issued].effect;
+    if (entry.held->store
+      && entry.station->getState() != ReservationStationState::WriteComplete)
+    {
+      memory->writeUWord(effect.storeAddress, effect.previousStoreValue);
+    }
+    entry.station->fastForward(skippedCycles, effect.arg1, effect.arg2,
+      effect.result);
+    entry.held->sequence += skippedInstructions;
+  }
+
+  // a register that is not renamed was last written by an instruction that
+  // completed, so it holds the model's value once the loop changed it
+  for (std::size_t i = 0; i < before.size(); i++)
+  {
+    auto reg = registerAt(i);
+    auto value = model.getRegisters().read(reg);
+    if (value.uw != before[i].uw
+      && renameRegisters->getRenaming(reg) == ReservationStationID::NONE)
+    {
+      registers->write(reg, value);
+    }
+  }
+
+  issued += skippedInstructions;
+  loops++;
+  iterations += count;
+  cycles += skippedCycles;
+  logger->info(TAG) << "Skipped " << count << " iterations of the loop at "
+    << util::hex<Address> << pc << ", " << std::dec << skippedCycles
+    << " cycles";
+  return skippedCycles;
+}
+
+bool FastForward::runIteration(const Issued* path, std::size_t length)
+{
+  iteration.clear();
+  TraceRecord record;
+  bool followed = true;
+  for (std::size_t i = 0; followed && i < length; i++)
+  {
+    auto pc = model.getPC();
+    followed = isAt(path[i]);
+    if (followed)
+    {
+      try
+      {
+        model.step(record);
+        iteration.push_back(Step{ pc, model.lastEffect() });
+      }
+      catch (const Exception&)
+      {
+        // the processor reports it when it gets there
+        followed = false;
+      }
+    }
+  }
+  // the processor continues from the start of the path, so the iteration must 
+  // also lead back there
+  followed = followed && isAt(path[0]);
+
+  if (!followed)
+  {
+    for (auto step = iteration.rbegin(); step != iteration.rend(); ++step)
+    {
+      model.undo(step->pc, step->effect);
+    }
+  }
+  return followed;
+}
+
+bool FastForward::isAt(const Issued& expected) const
+{
+  auto pc = model.getPC();
+  return pc == expected.address 
+    && modelMemory->readUWord(pc) == expected.instruction;
+}
+
+void FastForward::clearHistory()
+{
+  history.clear();
+  historyStart = issued;
+  candidates.clear();
+}
+
+void FastForward::disable(const std::string& reason)
+{
+  logger->warning(TAG) << "Loops are no longer skipped: " << reason;
+  enabled = false;
+}
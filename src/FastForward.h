@@ -0,0 +1,166 @@
+#ifndef __FASTFORWARD_H__
+#define __FASTFORWARD_H__
+
+#include "types.h"
+#include "Memory.h"
+#include "RegisterFile.h"
+#include "RenameRegisterFile.h"
+#include "ReservationStationID.h"
+#include "PerformanceCounters.h"
+#include "FunctionalModel.h"
+#include "instructions/Instruction.h"
+#include <unordered_map>
+#include <vector>
+#include <ostream>
+
+class FunctionalUnit;
+class FastForward;
+using FastForwardPtr = Pointer<FastForward>;
+
+/**
+ * Skips the repeated iterations of loops once their timing becomes periodic.
+ *
+ * A FunctionalModel is stepped as each instruction issues, so it always holds
+ * the architectural state after every issued instruction.  Whenever a branch
+ * sends the PC backwards, everything that decides the processor's timing
+ * (station states, ages, remaining cycles and operand sources, and the
+ * rename table, but no data) is compared with the last time the PC was
+ * there.  Timing never depends on data, so when they match, the cycles in
+ * between repeat for as long as the same instructions issue.  The model then
+ * executes whole iterations while they follow the same instructions, and the
+ * processor jumps ahead that many periods: the counters grow by the period's
+ * counts, and registers, memory and in flight instructions take their values
+ * from the model.
+ *
+ * Periods that issue a trap are not skipped, since traps print when they
+ * execute rather than when they issue.
+ */
+class FastForward
+{
+private:
+  /**
+   * An instruction issued since the history was last cleared.
+   */
+  struct Issued
+  {
+    Address address;
+    UWord instruction;
+  };
+
+  /**
+   * The state at the last backwards branch to an address.
+   */
+  struct Candidate
+  {
+    std::vector<uint64_t> signature;
+    std::vector<PerformanceCounters::Counter> counters;
+    std::size_t clock;
+    uint64_t issued;
+    uint64_t traps;
+    uint64_t staleWrites;
+  };
+
+  /**
+   * The instruction held by a station.
+   */
+  struct InFlight
+  {
+    uint64_t sequence;
+    bool store;
+  };
+
+  /**
+   * An instruction executed while skipping, so it can be undone.
+   */
+  struct Step
+  {
+    Address pc;
+    FunctionalEffect effect;
+  };
+
+  std::ostream discard;
+  MemoryPtr modelMemory;
+  FunctionalModel model;
+  // the processor's components
+  MemoryPtr memory;
+  RegisterFilePtr registers;
+  RenameRegisterFilePtr renameRegisters;
+  PerformanceCountersPtr counters;
+  std::vector<Pointer<FunctionalUnit>> units;
+  // cleared when the model cannot follow the processor
+  bool enabled;
+  Address lastPC;
+  uint64_t issued;
+  uint64_t traps;
+  // register writes that left a stale value in the register file
+  uint64_t staleWrites;
+  // the instructions issued since historyStart
+  std::vector<Issued> history;
+  uint64_t historyStart;
+  std::unordered_map<ReservationStationID, InFlight, ReservationStationIDHash>
+    inFlight;
+  std::unordered_map<Address, Candidate> candidates;
+  std::vector<uint64_t> signature;
+  // the iteration being executed by skip(), and the last one completed
+  std::vector<Step> iteration;
+  std::vector<Step> lastIteration;
+  uint64_t loops;
+  uint64_t iterations;
+  uint64_t cycles;
+
+public:
+  /**
+   * The model runs on its own copy of memory, which must still hold the
+   * program image, from entryPoint.  The other components are the
+   * processor's, and are changed when a loop is skipped.
+   */
+  FastForward(MemoryPtr memory, RegisterFilePtr registers,
+    RenameRegisterFilePtr renameRegisters, PerformanceCountersPtr counters,
+    Address entryPoint);
+  FastForward(const FastForward&) = delete;
+  FastForward& operator=(const FastForward&) = delete;
+
+  void addFunctionalUnit(Pointer<FunctionalUnit> unit);
+
+  uint64_t loopsSkipped() const;
+  uint64_t iterationsSkipped() const;
+  uint64_t cyclesSkipped() const;
+
+  /**
+   * Steps the model past the instruction issued to station.
+   */
+  void issue(const ReservationStationID& station,
+    const Instruction& instruction);
+
+  /**
+   * Notes a value written to the register file from the CDB.
+   */
+  void registerWrite(const RegisterID& dest);
+
+  /**
+   * Called at the end of every cycle with the address issue continues from.
+   * Returns the number of cycles skipped, at most maxCycles, which the caller
+   * adds to its clock.
+   */
+  std::size_t endCycle(std::size_t clock, Address pc, bool stallIssue,
+    std::size_t maxCycles);
+
+private:
+  void writeSignature(std::size_t clock);
+  std::size_t skip(const Candidate& start, std::size_t clock, Address pc,
+    std::size_t maxCycles);
+  /**
+   * Executes the next length instructions of path in the model.  If the
+   * program leaves the path, or does not return to its start, they are
+   * undone and false is returned.
+   */
+  bool runIteration(const Issued* path, std::size_t length);
+  /**
+   * Whether expected is the model's next instruction.
+   */
+  bool isAt(const Issued& expected) const;
+  void clearHistory();
+  void disable(const std::string& reason);
+};
+
+#endif
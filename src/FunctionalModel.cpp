@@ -0,0 +1,166 @@
+#include "FunctionalModel.h"
+#include "MachineConfig.h"
+#include "log.h"
+#include "instructions/BranchInstruction.h"
+#include "utility/stream_manip.h"
+#include <cassert>
+#include <string>
+
+static const std::string TAG = "FunctionalModel";
+
+FunctionalModel::FunctionalModel(MemoryPtr memory, Address entryPoint,
+  std::ostream& output)
+  : pc(entryPoint),
+    halted(false),
+    executed(0),
+    effect(),
+    memory(memory),
+    registers(new RegisterFile(GPR_REGISTERS, FPR_REGISTERS)),
+    instructionFactory(nullptr)
+{
+  assert(memory != nullptr);
+  instructionFactory = InstructionFactoryPtr(
+    new InstructionFactory(pc, memory, registers, output)
+    );
+}
+
+bool FunctionalModel::isHalted() const
+{
+  return halted;
+}
+
+Address FunctionalModel::getPC() const
+{
+  return pc;
+}
+
+uint64_t FunctionalModel::instructions() const
+{
+  return executed;
+}
+
+const RegisterFile& FunctionalModel::getRegisters() const
+{
+  return *registers;
+}
+
+const FunctionalEffect& FunctionalModel::lastEffect() const
+{
+  return effect;
+}
+
+bool FunctionalModel::step(TraceRecord& out)
+{
+  if (halted)
+  {
+    return false;
+  }
+
+  out = TraceRecord{ pc, memory->readUWord(pc), 0, false };
+  effect = FunctionalEffect();
+  effect.dest = RegisterID::NONE;
+  auto instruction = instructionFactory->decode(out.instruction);
+  assert(instruction);
+
+  if (instruction->getName() == InstructionName::TRAP
+    && instruction->getImmediate() == 0)
+  {
+    logger->debug(TAG) << "Halted at " << util::hex<Address> << pc;
+    halted = true;
+    return true;
+  }
+
+  Data arg1 = { 0 };
+  Data arg2 = { 0 };
+  if (instruction->getArg1() != RegisterID::NONE)
+  {
+    arg1 = registers->read(instruction->getArg1());
+  }
+  if (instruction->getArg2() != RegisterID::NONE)
+  {
+    arg2 = registers->read(instruction->getArg2());
+  }
+
+  auto result = instruction->execute(arg1, arg2);
+  effect.arg1 = arg1;
+  effect.arg2 = arg2;
+  effect.result = result;
+  auto next = pc + 4;
+  switch (instruction->getWriteAction())
+  {
+  case WriteAction::None:
+    break;
+
+  case WriteAction::Register:
+    effect.previousValue = registers->read(instruction->getDest());
+    registers->write(instruction->getDest(), result);
+    effect.dest = instruction->getDest();
+    effect.value = result;
+    if (instruction->getType() == FunctionalUnitType::Memory)
+    {
+      out.effectiveAddress = arg1.uw + static_cast<Word>(
+        static_cast<HalfWord>(instruction->getImmediate()));
+    }
+    break;
+
+  case WriteAction::PC:
+    out.taken = result.uw != next;
+    next = result.uw;
+    break;
+
+  case WriteAction::PC_R31:
+  {
+    auto bInstr = std::dynamic_pointer_cast<BranchInstruction>(instruction);
+    assert(bInstr);
+    Data link;
+    link.uw = bInstr->getNextInstruction();
+    effect.previousValue = registers->read(instruction->getDest());
+    registers->write(instruction->getDest(), link);
+    effect.dest = instruction->getDest();
+    effect.value = link;
+    out.taken = true;
+    next = bInstr->getTarget();
+  }
+    break;
+
+  case WriteAction::Memory:
+    effect.previousStoreValue = memory->readUWord(result.uw);
+    memory->writeUWord(result.uw, arg2.uw);
+    out.effectiveAddress = result.uw;
+    effect.store = true;
+    effect.storeAddress = result.uw;
+    effect.storeValue = arg2.uw;
+    break;
+  }
+
+  pc = next;
+  executed++;
+  return true;
+}
+
+void FunctionalModel::undo(Address pc, const FunctionalEffect& effect)
+{
+  assert(executed > 0);
+  if (effect.dest != RegisterID::NONE)
+  {
+    registers->write(effect.dest, effect.previousValue);
+  }
+  if (effect.store)
+  {
+    memory->writeUWord(effect.storeAddress, effect.previousStoreValue);
+  }
+  this->pc = pc;
+  executed--;
+}
+
+void FunctionalModel::run(TraceWriter* trace)
+{
+  TraceRecord record;
+  while (step(record))
+  {
+    if (trace)
+    {
+      trace->write(record);
+    }
+  }
+}
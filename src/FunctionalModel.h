@@ -0,0 +1,90 @@
+#ifndef __FUNCTIONALMODEL_H__
+#define __FUNCTIONALMODEL_H__
+
+#include "types.h"
+#include "Memory.h"
+#include "RegisterFile.h"
+#include "InstructionTrace.h"
+#include "instructions/InstructionFactory.h"
+#include <ostream>
+#include <iostream>
+
+class FunctionalModel;
+using FunctionalModelPtr = Pointer<FunctionalModel>;
+
+/**
+ * The architectural state changed by one instruction.
+ */
+struct FunctionalEffect
+{
+  // the register written and its value, RegisterID::NONE if none
+  RegisterID dest;
+  Data value;
+  bool store;
+  Address storeAddress;
+  UWord storeValue;
+  // the operands read and the value computed, as a reservation station holds 
+  // them
+  Data arg1;
+  Data arg2;
+  Data result;
+  // what the register and the stored word held before, for undo()
+  Data previousValue;
+  UWord previousStoreValue;
+};
+
+/**
+ * Executes a program one instruction at a time, in order and without 
+ * timing, using the same instruction semantics as Tomasulo.
+ */
+class FunctionalModel
+{
+private:
+  Address pc;
+  bool halted;
+  uint64_t executed;
+  FunctionalEffect effect;
+  MemoryPtr memory;
+  RegisterFilePtr registers;
+  InstructionFactoryPtr instructionFactory;
+
+public:
+  /**
+   * Trap output is written to output.
+   */
+  explicit FunctionalModel(MemoryPtr memory, Address entryPoint = 0,
+    std::ostream& output = std::cout);
+  FunctionalModel(const FunctionalModel&) = delete;
+  FunctionalModel& operator=(const FunctionalModel&) = delete;
+
+  bool isHalted() const;
+  Address getPC() const;
+  uint64_t instructions() const;
+  const RegisterFile& getRegisters() const;
+
+  /**
+   * What the last instruction stepped changed.
+   */
+  const FunctionalEffect& lastEffect() const;
+
+  /**
+   * Executes the instruction at the PC, describing it in out.  The halting 
+   * trap is described but does not count as executed.  Returns false if the 
+   * program had already halted.
+   */
+  bool step(TraceRecord& out);
+
+  /**
+   * Reverts the last instruction stepped and not yet undone, which was at pc 
+   * and had effect.
+   */
+  void undo(Address pc, const FunctionalEffect& effect);
+
+  /**
+   * Executes until the program halts, writing every instruction to trace 
+   * when it is given.
+   */
+  void run(TraceWriter* trace = nullptr);
+};
+
+#endif
@@ -13,23 +13,35 @@ FunctionalUnit::FunctionalUnit(FunctionalUnitType type,
   std::size_t executeCycles,
   std::size_t numStations,
   std::size_t numExecuteUnits,
-  ReservationStationDependencies& deps)
+  ReservationStationDependencies& deps,
+  PerformanceCountersPtr perfCounters)
   : type(type),
     executeInOrder(executeInOrder),
     numExecuteUnits(numExecuteUnits),
-    idleStations(),
-    issuedStations(),
-    executingStations(),
-    writingStations()
+    table(numStations),
+    stations(),
+    idleStations(numStations),
+    issuedStations(numStations),
+    executingStations(numStations),
+    writingStations(numStations),
+    ageOrder(),
+    perfCounters(perfCounters),
+    counters(perfCounters->addFunctionalUnit(
+      type, numStations, numExecuteUnits
+      )),
+    dumpedStationsUsed(0),
+    dumpedUnitsUsed(0)
 {
+  stations.reserve(numStations);
+  ageOrder.reserve(numStations);
   for (std::size_t i = 0; i < numStations; i++)
   {
     ReservationStationID id = { type, i };
-    auto rs = ReservationStationPtr(
-      new ReservationStation(id, executeCycles, deps)
-      );
-    allStations.push_back(rs);
-    idleStations.push_back(rs);
+    stations.push_back(ReservationStationPtr(
+      new ReservationStation(id, executeCycles, deps, table, 
+        &counters.waitingCycles[i])
+      ));
+    idleStations.insert(i);
   }
 }
 
@@ -39,54 +51,79 @@ bool FunctionalUnit::idle() const
     && writingStations.empty();
 }
 
+std::size_t FunctionalUnit::numStations() const
+{
+  return stations.size();
+}
+
+const ReservationStation& FunctionalUnit::getStation(std::size_t idx) const
+{
+  assert(idx < stations.size());
+  return *stations[idx];
+}
+
+ReservationStation& FunctionalUnit::getStation(std::size_t idx)
+{
+  assert(idx < stations.size());
+  return *stations[idx];
+}
+
 bool FunctionalUnit::issue(InstructionPtr instruction, std::size_t clock)
 {
   assert(instruction != nullptr);
 
-  if (idleStations.empty())
+  auto idx = idleStations.first();
+  if (idx == StationSet::npos)
   {
     logger->debug(TAG) << type << " stations full, cannot issue " 
       << instruction->getName();
+    counters.stationsFullStalls++;
     return false;
   }
 
-  auto rs = idleStations.front();
-  idleStations.pop_front();
-  rs->setInstruction(instruction, clock);
-  issuedStations.push_back(rs);
+  idleStations.erase(idx);
+  stations[idx]->setInstruction(instruction, clock);
+  issuedStations.insert(idx);
+  ageOrder.push_back(idx);
+  counters.issued++;
   return true;
 }
 
 void FunctionalUnit::execute()
 {
-  for (auto rs : executingStations)
+  for (auto idx = executingStations.first(); idx != StationSet::npos;
+    idx = executingStations.next(idx + 1))
   {
-    rs->execute();
+    stations[idx]->execute();
   }
 }
 
 void FunctionalUnit::write()
 {
-  for (auto rs : writingStations)
+  for (auto idx = writingStations.first(); idx != StationSet::npos;
+    idx = writingStations.next(idx + 1))
   {
-    rs->write();
+    stations[idx]->write();
   }
 }
 
 void FunctionalUnit::advanceInstructions()
 {
   // retire completed
-  auto writePred = [&](ReservationStationPtr rs) {
-    if (rs->getState() == ReservationStationState::WriteComplete)
+  for (auto idx = writingStations.first(); idx != StationSet::npos;
+    idx = writingStations.next(idx + 1))
+  {
+    if (table.states[idx] != ReservationStationState::WriteComplete)
     {
-      rs->clearInstruction();
-      idleStations.push_back(rs);
-      return true;
+      continue;
     }
 
-    return false;
-  };
-  writingStations.remove_if(writePred);
+    stations[idx]->clearInstruction();
+    writingStations.erase(idx);
+    idleStations.insert(idx);
+    ageOrder.erase(std::find(ageOrder.begin(), ageOrder.end(), idx));
+    counters.retired++;
+  }
 
   if (executeInOrder)
   {
@@ -98,102 +135,224 @@ void FunctionalUnit::advanceInstructions()
   }
 }
 
-void FunctionalUnit::dumpState() const
+void FunctionalUnit::reset()
+{
+  idleStations.clear();
+  issuedStations.clear();
+  executingStations.clear();
+  writingStations.clear();
+  for (std::size_t i = 0; i < stations.size(); i++)
+  {
+    stations[i]->reset();
+    idleStations.insert(i);
+  }
+  ageOrder.clear();
+  dumpedStationsUsed = 0;
+  dumpedUnitsUsed = 0;
+}
+
+void FunctionalUnit::updateCounters()
+{
+  auto unitsUsed = executingStations.size() + writingStations.size();
+  auto stationsUsed = issuedStations.size() + unitsUsed;
+  counters.occupiedStationCycles += stationsUsed;
+  counters.executeBusyCycles += unitsUsed;
+  if (perfCounters->occupancy)
+  {
+    perfCounters->occupancy->addCycle(type, stationsUsed, unitsUsed);
+  }
+}
+
+void FunctionalUnit::writeSignature(std::size_t clock, 
+  std::vector<uint64_t>& out) const
+{
+  // the order of the busy stations follows from their ages, and the stage 
+  // sets from their states
+  for (const auto& rs : stations)
+  {
+    rs->writeSignature(clock, out);
+  }
+}
+
+void FunctionalUnit::dumpState(std::ostream& os) const
+{
+  dumpUsage(os);
+  for (const auto& rs : stations)
+  {
+    rs->dumpState(os);
+  }
+}
+
+void FunctionalUnit::dumpChanges(bool full)
 {
-  auto idle = idleStations.size();
   auto used = issuedStations.size() + executingStations.size() 
     + writingStations.size();
   auto unitsUsed = used - issuedStations.size();
-  std::cout << type << " Functional Unit" << std::endl;
-  std::cout << "\t" << "Stations: " << std::dec << used << " in use, "
-    << idle << " idle" << std::endl;
-  std::cout << "\t" << "ExecuteUnits: " << unitsUsed << " in use, " 
-    << (numExecuteUnits - unitsUsed) << " idle" << std::endl;
+  if (full)
+  {
+    dumpUsage();
+  }
+  else if (used != dumpedStationsUsed || unitsUsed != dumpedUnitsUsed)
+  {
+    std::cout << type << " Functional Unit: " << std::dec << used 
+      << " stations in use, " << unitsUsed << " execute units in use" 
+      << std::endl;
+  }
+  dumpedStationsUsed = used;
+  dumpedUnitsUsed = unitsUsed;
 
-  for (auto rs : allStations)
+  for (const auto& rs : stations)
   {
-    rs->dumpState();
+    rs->dumpChanges(full);
   }
 }
 
-bool FunctionalUnit::executeUnitsAvailable()
+void FunctionalUnit::dumpUsage(std::ostream& os) const
+{
+  auto idle = idleStations.size();
+  auto used = issuedStations.size() + executingStations.size() 
+    + writingStations.size();
+  auto unitsUsed = used - issuedStations.size();
+  os << type << " Functional Unit" << std::endl;
+  os << "\t" << "Stations: " << std::dec << used << " in use, "
+    << idle << " idle" << std::endl;
+  os << "\t" << "ExecuteUnits: " << unitsUsed << " in use, " 
+    << (numExecuteUnits - unitsUsed) << " idle" << std::endl;
+}
+
+bool FunctionalUnit::executeUnitsAvailable() const
 {
   return (executingStations.size() + writingStations.size()) < numExecuteUnits;
 }
 
 void FunctionalUnit::inOrderAdvance()
 { 
+  // in order, the busy stations are always writing, then executing, then 
+  // issued when walked from oldest to youngest
+
   // move from execute to write
-  while (!executingStations.empty())
+  std::size_t pos = 0;
+  for (; pos < ageOrder.size(); pos++)
   {
-    auto rs = executingStations.front();
-    if (rs->getState() != ReservationStationState::ExecutionComplete)
+    auto idx = ageOrder[pos];
+    if (writingStations.contains(idx))
+    {
+      continue;
+    }
+    if (!executingStations.contains(idx)
+      || table.states[idx] != ReservationStationState::ExecutionComplete)
     {
       break;
     }
 
-    executingStations.pop_front();
-    rs->setIsWriting();
-    writingStations.push_back(rs);
+    moveToWrite(idx);
   }
 
   // move from issued to execute
-  while (!issuedStations.empty())
+  for (; pos < ageOrder.size(); pos++)
   {
-    auto rs = issuedStations.front();
-    if (rs->getState() != ReservationStationState::ReadyToExecute)
+    auto idx = ageOrder[pos];
+    if (!issuedStations.contains(idx))
+    {
+      continue;
+    }
+    if (table.states[idx] != ReservationStationState::ReadyToExecute)
     {
       break;
     }
 
     if (!executeUnitsAvailable())
     {
-      auto func = [&](ReservationStationPtr rs) {
-        if (rs->getState() == ReservationStationState::ReadyToExecute)
+      for (; pos < ageOrder.size(); pos++)
+      {
+        auto waiting = ageOrder[pos];
+        if (table.states[waiting] == ReservationStationState::ReadyToExecute)
         {
-          logger->debug(TAG) << type << " execute units full, " << rs->getID()
-            << " waiting";
+          logger->debug(TAG) << type << " execute units full, " 
+            << stations[waiting]->getID() << " waiting";
+          countExecuteWait(waiting);
         }
-      };
-      std::for_each(issuedStations.begin(), issuedStations.end(), func);      
+      }
       break;
     }
 
-    issuedStations.pop_front();
-    rs->setIsExecuting();
-    executingStations.push_back(rs);
+    moveToExecute(idx);
   }
 }
 
 void FunctionalUnit::outOfOrderAdvance()
 {
   // move from execute to write
-  auto execPred = [&](ReservationStationPtr rs) {
-    if (rs->getState() == ReservationStationState::ExecutionComplete)
+  for (auto idx = executingStations.first(); idx != StationSet::npos;
+    idx = executingStations.next(idx + 1))
+  {
+    if (table.states[idx] == ReservationStationState::ExecutionComplete)
     {
-      rs->setIsWriting();
-      writingStations.push_back(rs);
-      return true;
+      moveToWrite(idx);
     }
-    return false;
-  };
-  executingStations.remove_if(execPred);
+  }
 
-  // move from issued to execute
-  auto issuePred = [&](ReservationStationPtr rs) {
-    if (rs->getState() == ReservationStationState::ReadyToExecute)
+  // move from issued to execute, oldest first
+  for (auto idx : ageOrder)
+  {
+    if (!issuedStations.contains(idx)
+      || table.states[idx] != ReservationStationState::ReadyToExecute)
     {
-      if (!executeUnitsAvailable())
-      {
-        logger->debug(TAG) << type << " execute units full, " << rs->getID()
-          << " waiting";
-        return false;
-      }
-      rs->setIsExecuting();
-      executingStations.push_back(rs);
-      return true;
+      continue;
     }
-    return false;
-  };
-  issuedStations.remove_if(issuePred);
+
+    if (!executeUnitsAvailable())
+    {
+      logger->debug(TAG) << type << " execute units full, " 
+        << stations[idx]->getID() << " waiting";
+      countExecuteWait(idx);
+      continue;
+    }
+
+    moveToExecute(idx);
+  }
+}
+
+CPICategory FunctionalUnit::stallCategory() const
+{
+  if (ageOrder.empty())
+  {
+    return CPICategory::Stations;
+  }
+
+  switch (table.states[ageOrder.front()])
+  {
+  case ReservationStationState::WaitingForArgs:
+    return CPICategory::DataDependence;
+  case ReservationStationState::ReadyToExecute:
+    return CPICategory::ExecuteUnits;
+  case ReservationStationState::Writing:
+    // still writing after the commit means it lost arbitration
+    return CPICategory::CDBContention;
+  default:
+    return CPICategory::Stations;
+  }
+}
+
+void FunctionalUnit::countExecuteWait(std::size_t idx)
+{
+  if (perfCounters->pcProfile)
+  {
+    perfCounters->pcProfile->at(stations[idx]->getAddress())
+      .executeWaitCycles++;
+  }
+}
+
+void FunctionalUnit::moveToExecute(std::size_t idx)
+{
+  issuedStations.erase(idx);
+  stations[idx]->setIsExecuting();
+  executingStations.insert(idx);
+}
+
+void FunctionalUnit::moveToWrite(std::size_t idx)
+{
+  executingStations.erase(idx);
+  stations[idx]->setIsWriting();
+  writingStations.insert(idx);
 }
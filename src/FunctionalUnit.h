@@ -1,10 +1,14 @@
 #ifndef __FUNCTIONALUNIT_H__
-#define __FUNCTIONALUINT_H__
+#define __FUNCTIONALUNIT_H__
 
 #include "types.h"
 #include "ReservationStation.h"
+#include "StationSet.h"
+#include "PerformanceCounters.h"
+#include "CPIStack.h"
 #include "instructions/Instruction.h"
-#include <list>
+#include <vector>
+#include <iostream>
 
 class FunctionalUnit;
 using FunctionalUnitPtr = Pointer<FunctionalUnit>;
@@ -12,16 +16,23 @@ using FunctionalUnitPtr = Pointer<FunctionalUnit>;
 class FunctionalUnit
 {
 private:
-  using ReservationStationList = std::list<ReservationStationPtr>;
-
   FunctionalUnitType type;
   bool executeInOrder;
   const std::size_t numExecuteUnits;
-  ReservationStationList allStations;
-  ReservationStationList idleStations;
-  ReservationStationList issuedStations;
-  ReservationStationList executingStations;
-  ReservationStationList writingStations;
+  StationTable table;
+  std::vector<ReservationStationPtr> stations;
+  // the stations in each stage, as indices into stations
+  StationSet idleStations;
+  StationSet issuedStations;
+  StationSet executingStations;
+  StationSet writingStations;
+  // indices of all non-idle stations, oldest first
+  std::vector<std::size_t> ageOrder;
+  PerformanceCountersPtr perfCounters;
+  FunctionalUnitCounters& counters;
+  // counts printed by the last dumpChanges()
+  std::size_t dumpedStationsUsed;
+  std::size_t dumpedUnitsUsed;
 
 public:
   FunctionalUnit(FunctionalUnitType type, 
@@ -29,21 +40,60 @@ public:
     std::size_t executeCycles,
     std::size_t numStations,
     std::size_t numExecuteUnits,
-    ReservationStationDependencies& deps);
+    ReservationStationDependencies& deps,
+    PerformanceCountersPtr perfCounters);
   FunctionalUnit& operator=(FunctionalUnit&);
 
   bool idle() const;
+  std::size_t numStations() const;
+  const ReservationStation& getStation(std::size_t idx) const;
+  ReservationStation& getStation(std::size_t idx);
 
   bool issue(InstructionPtr instruction, std::size_t clock);
   void execute();
   void write();
   void advanceInstructions();
-  void dumpState() const;
+
+  /**
+   * Empties every station without retiring their instructions.
+   */
+  void reset();
+
+  /**
+   * Adds the current cycle's execute unit usage and operand waits to the 
+   * performance counters.  Called once at the end of every cycle.
+   */
+  void updateCounters();
+
+  /**
+   * Why this unit's stations are still occupied, judged by the oldest busy 
+   * station.  Called at the end of a cycle in which issue found the stations 
+   * full.
+   */
+  CPICategory stallCategory() const;
+
+  /**
+   * Appends the signature of every station, see 
+   * ReservationStation::writeSignature().
+   */
+  void writeSignature(std::size_t clock, std::vector<uint64_t>& out) const;
+
+  void dumpState(std::ostream& os = std::cout) const;
+
+  /**
+   * Prints only the station and execute unit usage that changed since the 
+   * last call, or the full state when full is set.
+   */
+  void dumpChanges(bool full);
 
 private:
-  bool executeUnitsAvailable();
+  void dumpUsage(std::ostream& os = std::cout) const;
+  bool executeUnitsAvailable() const;
   void inOrderAdvance();
   void outOfOrderAdvance();
+  void countExecuteWait(std::size_t idx);
+  void moveToExecute(std::size_t idx);
+  void moveToWrite(std::size_t idx);
 };
 
 #endif
@@ -0,0 +1,90 @@
+#include "HostProfile.h"
+#include "MachineConfig.h"
+#include <iomanip>
+
+static const std::size_t NUM_STAGES = 
+  static_cast<std::size_t>(HostStage::DumpState) + 1;
+
+static const char* STAGE_NAMES[] = {
+  "Load",
+  "Advance instructions",
+  "Issue",
+  "Execute",
+  "Write",
+  "Counters",
+  "Dump state"
+};
+
+static double nanoseconds(HostProfile::Clock::duration d)
+{
+  return static_cast<double>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()
+    );
+}
+
+HostProfile::HostProfile()
+  : elapsed(NUM_STAGES, Clock::duration::zero()),
+    lapStart(Clock::now())
+{
+}
+
+void HostProfile::start()
+{
+  lapStart = Clock::now();
+}
+
+void HostProfile::lap(HostStage stage)
+{
+  auto now = Clock::now();
+  elapsed[static_cast<std::size_t>(stage)] += now - lapStart;
+  lapStart = now;
+}
+
+HostProfile::Clock::duration HostProfile::total(HostStage stage) const
+{
+  return elapsed[static_cast<std::size_t>(stage)];
+}
+
+void HostProfile::writeReport(std::ostream& os, uint64_t cycles,
+  uint64_t instructions) const
+{
+  // everything but loading is simulation time
+  double simulated = 0;
+  for (std::size_t i = 1; i < NUM_STAGES; i++)
+  {
+    simulated += nanoseconds(elapsed[i]);
+  }
+  double seconds = simulated / 1e9;
+
+  os << std::dec << std::fixed << std::setfill(' ') << std::setprecision(3);
+  os << "Host profile" << std::endl;
+  os << "\tLoad: " << nanoseconds(total(HostStage::Load)) / 1e6 << " ms" 
+    << std::endl;
+  os << "\tSimulation: " << simulated / 1e6 << " ms for " << cycles 
+    << " cycles and " << instructions << " instructions" << std::endl;
+  os << std::setprecision(0);
+  os << "\tCycles/sec: " << ratio(static_cast<double>(cycles), seconds) 
+    << std::endl;
+  os << "\tInstructions/sec: " 
+    << ratio(static_cast<double>(instructions), seconds) << std::endl;
+
+  os << std::setprecision(1);
+  os << "\t" << std::left << std::setw(22) << "Stage" << std::right 
+    << std::setw(12) << "ms" << std::setw(12) << "ns/cycle" 
+    << std::setw(10) << "Percent" << std::endl;
+  for (std::size_t i = 1; i < NUM_STAGES; i++)
+  {
+    auto ns = nanoseconds(elapsed[i]);
+    os << "\t" << std::left << std::setw(22) << STAGE_NAMES[i] << std::right 
+      << std::setprecision(3) << std::setw(12) << ns / 1e6 
+      << std::setprecision(1) << std::setw(12) 
+      << ratio(ns, static_cast<double>(cycles)) << std::setw(9) 
+      << 100 * ratio(ns, simulated) << "%" << std::endl;
+  }
+  os << "\t" << std::left << std::setw(22) << "Total" << std::right 
+    << std::setprecision(3) << std::setw(12) << simulated / 1e6 
+    << std::setprecision(1) << std::setw(12) 
+    << ratio(simulated, static_cast<double>(cycles)) << std::endl;
+
+  os.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,65 @@
+#ifndef __HOSTPROFILE_H__
+#define __HOSTPROFILE_H__
+
+#include "types.h"
+#include <chrono>
+#include <vector>
+#include <ostream>
+
+class HostProfile;
+using HostProfilePtr = Pointer<HostProfile>;
+
+/**
+ * The parts of the simulator timed by a HostProfile.
+ */
+enum class HostStage
+{
+  Load,
+  AdvanceInstructions,
+  Issue,
+  Execute,
+  Write,
+  Counters,
+  DumpState
+};
+
+/**
+ * Measures the host wall time spent in each stage of the simulator.  Stages 
+ * are timed as consecutive laps so every measurement costs a single clock 
+ * read.
+ */
+class HostProfile
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+private:
+  std::vector<Clock::duration> elapsed;
+  Clock::time_point lapStart;
+
+public:
+  HostProfile();
+  HostProfile(const HostProfile&) = delete;
+  HostProfile& operator=(const HostProfile&) = delete;
+
+  /**
+   * Starts timing the next lap.
+   */
+  void start();
+
+  /**
+   * Charges the time since the last start() or lap() to stage.
+   */
+  void lap(HostStage stage);
+
+  Clock::duration total(HostStage stage) const;
+
+  /**
+   * Writes the time per stage along with the simulation rate for the given 
+   * number of simulated cycles and retired instructions.
+   */
+  void writeReport(std::ostream& os, uint64_t cycles, 
+    uint64_t instructions) const;
+};
+
+#endif
@@ -0,0 +1,345 @@
+#include "InstructionTrace.h"
+#include <algorithm>
+#include <cstring>
+
+// identifies a trace file, and the end of a complete one
+static const char HEADER[8] = { 'T', 'M', 'T', 'R', 'A', 'C', 'E', '2' };
+static const char FOOTER[8] = { 'T', 'M', 'T', 'R', 'I', 'D', 'X', '2' };
+static const uint32_t CHUNK_RECORDS = 65536;
+
+// bits or'd into the shifted address difference of a record
+static const uint32_t HAS_INSTRUCTION = 1;
+static const uint32_t HAS_EFFECTIVE_ADDRESS = 2;
+static const uint32_t TAKEN = 4;
+static const int FLAG_BITS = 3;
+
+static uint64_t zigzag(int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^ (value < 0 ? ~0ull : 0);
+}
+
+static int64_t unzigzag(uint64_t value)
+{
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static void putVarint(std::vector<Byte>& out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<Byte>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<Byte>(value));
+}
+
+/**
+ * Reads a varint from in at pos, returning false if it runs past the end.
+ */
+static bool getVarint(const std::vector<Byte>& in, std::size_t& pos, 
+  uint64_t& value)
+{
+  value = 0;
+  for (int shift = 0; pos < in.size() && shift < 64; shift += 7)
+  {
+    auto b = in[pos++];
+    value |= static_cast<uint64_t>(b & 0x7f) << shift;
+    if ((b & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename T>
+static void writeValue(std::ostream& os, T value)
+{
+  os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+static bool readValue(std::istream& is, T& value)
+{
+  return static_cast<bool>(
+    is.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+TraceWriter::TraceWriter(const std::string& filename)
+  : file(filename.c_str(), std::ios::out | std::ios::binary),
+    index(),
+    records(0),
+    payload(),
+    chunkRecords(0),
+    lastAddress(0),
+    instructions()
+{
+  file.write(HEADER, sizeof(HEADER));
+}
+
+TraceWriter::~TraceWriter()
+{
+  close();
+}
+
+bool TraceWriter::good() const
+{
+  return static_cast<bool>(file);
+}
+
+void TraceWriter::write(const TraceRecord& record)
+{
+  auto found = instructions.find(record.address);
+  bool newInstruction = found == instructions.end() 
+    || found->second.first != record.instruction;
+  auto& known = instructions[record.address];
+
+  // the first record of a chunk is relative to address 0 - 4
+  auto expected = chunkRecords == 0 ? -4 : static_cast<int64_t>(lastAddress);
+  auto head = zigzag(static_cast<int64_t>(record.address) - expected - 4) 
+    << FLAG_BITS;
+  if (newInstruction)
+  {
+    head |= HAS_INSTRUCTION;
+  }
+  if (record.effectiveAddress != 0)
+  {
+    head |= HAS_EFFECTIVE_ADDRESS;
+  }
+  if (record.taken)
+  {
+    head |= TAKEN;
+  }
+  putVarint(payload, head);
+
+  if (newInstruction)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      payload.push_back(static_cast<Byte>(record.instruction >> (8 * i)));
+    }
+    known.first = record.instruction;
+    known.second = 0;
+  }
+  if (record.effectiveAddress != 0)
+  {
+    putVarint(payload, zigzag(static_cast<int64_t>(record.effectiveAddress) 
+      - static_cast<int64_t>(known.second)));
+    known.second = record.effectiveAddress;
+  }
+
+  lastAddress = record.address;
+  records++;
+  if (++chunkRecords == CHUNK_RECORDS)
+  {
+    flushChunk();
+  }
+}
+
+bool TraceWriter::close()
+{
+  if (!file.is_open())
+  {
+    return true;
+  }
+
+  flushChunk();
+  for (const auto& chunk : index)
+  {
+    writeValue(file, chunk.offset);
+    writeValue(file, chunk.firstRecord);
+  }
+  writeValue(file, records);
+  writeValue(file, static_cast<uint32_t>(index.size()));
+  file.write(FOOTER, sizeof(FOOTER));
+  file.close();
+  return !file.fail();
+}
+
+void TraceWriter::flushChunk()
+{
+  if (chunkRecords == 0)
+  {
+    return;
+  }
+
+  index.push_back(TraceChunk{ static_cast<uint64_t>(file.tellp()), 
+    records - chunkRecords });
+  writeValue(file, chunkRecords);
+  writeValue(file, static_cast<uint32_t>(payload.size()));
+  file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+
+  payload.clear();
+  chunkRecords = 0;
+  instructions.clear();
+}
+
+TraceReader::TraceReader(const std::string& filename)
+  : file(filename.c_str(), std::ios::in | std::ios::binary),
+    valid(false),
+    index(),
+    nextChunk(0),
+    endChunk(0),
+    payload(),
+    position(0),
+    chunkRecords(0),
+    lastAddress(0),
+    instructions()
+{
+  char header[sizeof(HEADER)];
+  if (!file.read(header, sizeof(header)) 
+    || std::memcmp(header, HEADER, sizeof(HEADER)) != 0)
+  {
+    return;
+  }
+
+  // the footer is the record count, chunk count and FOOTER
+  char footer[sizeof(FOOTER)];
+  uint64_t totalRecords = 0;
+  uint32_t count = 0;
+  auto footerSize = static_cast<std::streamoff>(
+    sizeof(totalRecords) + sizeof(count) + sizeof(FOOTER));
+  file.seekg(-footerSize, std::ios::end);
+  if (!readValue(file, totalRecords) || !readValue(file, count)
+    || !file.read(footer, sizeof(footer))
+    || std::memcmp(footer, FOOTER, sizeof(FOOTER)) != 0)
+  {
+    return;
+  }
+
+  file.seekg(-footerSize - static_cast<std::streamoff>(
+    count * 2 * sizeof(uint64_t)), std::ios::end);
+  index.resize(count);
+  for (auto& chunk : index)
+  {
+    if (!readValue(file, chunk.offset) || !readValue(file, chunk.firstRecord))
+    {
+      return;
+    }
+  }
+  // the total is kept as the first record of a chunk past the end
+  index.push_back(TraceChunk{ 0, totalRecords });
+
+  valid = true;
+  selectChunks(0, count);
+}
+
+bool TraceReader::good() const
+{
+  return valid;
+}
+
+std::size_t TraceReader::chunks() const
+{
+  return index.empty() ? 0 : index.size() - 1;
+}
+
+uint64_t TraceReader::records() const
+{
+  return index.empty() ? 0 : index.back().firstRecord;
+}
+
+const TraceChunk& TraceReader::chunk(std::size_t i) const
+{
+  return index.at(i);
+}
+
+bool TraceReader::selectChunks(std::size_t first, std::size_t count)
+{
+  if (!valid || first > chunks())
+  {
+    return false;
+  }
+
+  nextChunk = first;
+  endChunk = first + std::min(count, chunks() - first);
+  payload.clear();
+  position = 0;
+  chunkRecords = 0;
+  return true;
+}
+
+bool TraceReader::next(TraceRecord& out)
+{
+  if (position == payload.size() && !readChunk())
+  {
+    return false;
+  }
+
+  uint64_t head = 0;
+  if (!getVarint(payload, position, head))
+  {
+    valid = false;
+    return false;
+  }
+
+  auto expected = chunkRecords == 0 ? -4 : static_cast<int64_t>(lastAddress);
+  out.address = static_cast<Address>(
+    expected + 4 + unzigzag(head >> FLAG_BITS));
+  out.taken = (head & TAKEN) != 0;
+
+  auto& known = instructions[out.address];
+  if (head & HAS_INSTRUCTION)
+  {
+    if (position + 4 > payload.size())
+    {
+      valid = false;
+      return false;
+    }
+    known.first = 0;
+    for (int i = 0; i < 4; i++)
+    {
+      known.first |= static_cast<UWord>(payload[position++]) << (8 * i);
+    }
+    known.second = 0;
+  }
+  out.instruction = known.first;
+
+  out.effectiveAddress = 0;
+  if (head & HAS_EFFECTIVE_ADDRESS)
+  {
+    uint64_t delta = 0;
+    if (!getVarint(payload, position, delta))
+    {
+      valid = false;
+      return false;
+    }
+    known.second = static_cast<Address>(
+      static_cast<int64_t>(known.second) + unzigzag(delta));
+    out.effectiveAddress = known.second;
+  }
+
+  lastAddress = out.address;
+  chunkRecords++;
+  return true;
+}
+
+bool TraceReader::readChunk()
+{
+  if (!valid || nextChunk >= endChunk)
+  {
+    return false;
+  }
+
+  uint32_t count = 0;
+  uint32_t bytes = 0;
+  file.clear();
+  file.seekg(static_cast<std::streamoff>(index[nextChunk].offset));
+  payload.resize(0);
+  if (readValue(file, count) && readValue(file, bytes))
+  {
+    payload.resize(bytes);
+    file.read(reinterpret_cast<char*>(payload.data()), bytes);
+  }
+  if (!file || payload.empty())
+  {
+    valid = false;
+    return false;
+  }
+
+  nextChunk++;
+  position = 0;
+  chunkRecords = 0;
+  instructions.clear();
+  return true;
+}
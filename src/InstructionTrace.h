@@ -0,0 +1,139 @@
+#ifndef __INSTRUCTIONTRACE_H__
+#define __INSTRUCTIONTRACE_H__
+
+#include "types.h"
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <fstream>
+
+class TraceWriter;
+using TraceWriterPtr = Pointer<TraceWriter>;
+class TraceReader;
+using TraceReaderPtr = Pointer<TraceReader>;
+
+/**
+ * One instruction of a program's dynamic instruction stream.
+ */
+struct TraceRecord
+{
+  Address address;
+  // the instruction word, which decodes to the instruction
+  UWord instruction;
+  // the address read or written by loads and stores, 0 otherwise
+  Address effectiveAddress;
+  // whether a branch was taken, false for other instructions
+  bool taken;
+};
+
+/**
+ * The position of a chunk in a trace file.
+ */
+struct TraceChunk
+{
+  uint64_t offset;
+  // the number of records before the chunk
+  uint64_t firstRecord;
+};
+
+/**
+ * Writes a dynamic instruction stream to a file in a compact form.  The file 
+ * is a header, a sequence of chunks, and an index of the chunks.  Records are 
+ * encoded relative to earlier records in the same chunk, so each chunk can be 
+ * decoded on its own:
+ * - a varint holding the zigzag difference between the address and the 
+ *   previous address + 4, shifted left 3, or'd with 1 when the instruction 
+ *   word follows, 2 when an effective address follows and 4 for a taken 
+ *   branch;
+ * - the instruction word, only the first time an address is seen in the 
+ *   chunk (or when the word at the address changed);
+ * - the zigzag varint difference between the effective address and the 
+ *   previous effective address of the same instruction.
+ * Memory use is bounded by the chunk size.
+ */
+class TraceWriter
+{
+private:
+  std::ofstream file;
+  std::vector<TraceChunk> index;
+  uint64_t records;
+  // the current chunk
+  std::vector<Byte> payload;
+  uint32_t chunkRecords;
+  Address lastAddress;
+  // the word and last effective address of each address in the chunk
+  std::unordered_map<Address, std::pair<UWord, Address>> instructions;
+
+public:
+  explicit TraceWriter(const std::string& filename);
+  TraceWriter(const TraceWriter&) = delete;
+  TraceWriter& operator=(const TraceWriter&) = delete;
+  ~TraceWriter();
+
+  bool good() const;
+  void write(const TraceRecord& record);
+
+  /**
+   * Writes the last chunk and the index.  Returns false if the file could 
+   * not be written.
+   */
+  bool close();
+
+private:
+  void flushChunk();
+};
+
+/**
+ * Reads a dynamic instruction stream written by TraceWriter, a chunk at a 
+ * time.  Chunks can be read from any point, so separate readers can replay 
+ * separate parts of one trace in parallel.
+ */
+class TraceReader
+{
+private:
+  std::ifstream file;
+  bool valid;
+  std::vector<TraceChunk> index;
+  // the chunk being read, and the chunk to stop before
+  std::size_t nextChunk;
+  std::size_t endChunk;
+  std::vector<Byte> payload;
+  std::size_t position;
+  uint32_t chunkRecords;
+  Address lastAddress;
+  std::unordered_map<Address, std::pair<UWord, Address>> instructions;
+
+public:
+  explicit TraceReader(const std::string& filename);
+  TraceReader(const TraceReader&) = delete;
+  TraceReader& operator=(const TraceReader&) = delete;
+
+  /**
+   * Whether the file was opened and is a complete trace.
+   */
+  bool good() const;
+
+  /**
+   * The number of chunks and records in the trace.
+   */
+  std::size_t chunks() const;
+  uint64_t records() const;
+  const TraceChunk& chunk(std::size_t i) const;
+
+  /**
+   * Limits reading to count chunks starting at first.  Returns false if 
+   * first is not a chunk.
+   */
+  bool selectChunks(std::size_t first, std::size_t count);
+
+  /**
+   * Reads the next record, returning false at the end of the selected 
+   * chunks.
+   */
+  bool next(TraceRecord& out);
+
+private:
+  bool readChunk();
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include "IntervalStats.h"
+#include "MachineConfig.h"
+#include "PerformanceCounters.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <sstream>
+
+static const char COLUMNAR_HEADER[8] = 
+  { 'T', 'M', 'I', 'N', 'T', 'V', '0', '1' };
+// rows buffered before a Columnar block is written
+static const std::size_t BLOCK_ROWS = 1024;
+
+static const char* COLUMNS[] = {
+  "start_cycle", "cycles", "retired", "ipc", "cdb_utilization", 
+  "cdb_rejections", "stations_full_stalls", "branch_stalls", 
+  "halted_stalls", "loads", "stores"
+};
+
+IntervalStats::IntervalStats(std::ostream& os, IntervalUnit unit, 
+  std::size_t length, IntervalFormat format)
+  : os(os),
+    unit(unit),
+    length(std::max<std::size_t>(length, 1)),
+    format(format),
+    last(),
+    columns(std::begin(COLUMNS), std::end(COLUMNS)),
+    block()
+{
+  last.occupiedStationCycles.assign(NUM_UNIT_TYPES, 0);
+  last.executeBusyCycles.assign(NUM_UNIT_TYPES, 0);
+  for (auto type : UNIT_TYPES)
+  {
+    std::ostringstream name;
+    name << type;
+    auto prefix = name.str();
+    std::transform(prefix.begin(), prefix.end(), prefix.begin(), ::tolower);
+    columns.push_back(prefix + "_stations");
+    columns.push_back(prefix + "_execute_units");
+  }
+
+  if (format == IntervalFormat::Csv)
+  {
+    for (std::size_t i = 0; i < columns.size(); i++)
+    {
+      os << (i == 0 ? "" : ",") << columns[i];
+    }
+    os << "\n";
+  }
+  else
+  {
+    os.write(COLUMNAR_HEADER, sizeof(COLUMNAR_HEADER));
+    auto count = static_cast<uint32_t>(columns.size());
+    os.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& column : columns)
+    {
+      os << column << '\n';
+    }
+    block.resize(columns.size());
+    for (auto& values : block)
+    {
+      values.reserve(BLOCK_ROWS);
+    }
+  }
+}
+
+void IntervalStats::endCycle(const PerformanceCounters& counters)
+{
+  bool complete = unit == IntervalUnit::Cycles 
+    ? counters.cycles - last.cycles >= length
+    : counters.retired() - last.retired >= length;
+  if (complete)
+  {
+    writeRow(counters);
+  }
+}
+
+void IntervalStats::finish(const PerformanceCounters& counters)
+{
+  if (counters.cycles > last.cycles)
+  {
+    writeRow(counters);
+  }
+  if (format == IntervalFormat::Columnar)
+  {
+    flushBlock();
+  }
+  os.flush();
+}
+
+IntervalStats::Snapshot IntervalStats::snapshot(
+  const PerformanceCounters& counters) const
+{
+  Snapshot now;
+  now.cycles = counters.cycles;
+  now.retired = counters.retired();
+  now.cdbGrants = counters.cdbGrants;
+  now.cdbRejections = counters.cdbRejections;
+  now.stationsFullStalls = counters.stationsFullStalls();
+  now.branchStalls = counters.branchStalls;
+  now.haltedStalls = counters.haltedStalls;
+  now.loads = counters.loads;
+  now.stores = counters.stores;
+  now.occupiedStationCycles.resize(NUM_UNIT_TYPES);
+  now.executeBusyCycles.resize(NUM_UNIT_TYPES);
+  for (auto type : UNIT_TYPES)
+  {
+    auto t = static_cast<std::size_t>(type);
+    const auto& unit = counters.getFunctionalUnit(type);
+    now.occupiedStationCycles[t] = unit.occupiedStationCycles;
+    now.executeBusyCycles[t] = unit.executeBusyCycles;
+  }
+  return now;
+}
+
+void IntervalStats::writeRow(const PerformanceCounters& counters)
+{
+  auto now = snapshot(counters);
+  auto cycles = static_cast<double>(now.cycles - last.cycles);
+  auto retired = static_cast<double>(now.retired - last.retired);
+
+  std::vector<double> row = {
+    static_cast<double>(last.cycles + 1),
+    cycles,
+    retired,
+    ratio(retired, cycles),
+    ratio(static_cast<double>(now.cdbGrants - last.cdbGrants), cycles),
+    static_cast<double>(now.cdbRejections - last.cdbRejections),
+    static_cast<double>(now.stationsFullStalls - last.stationsFullStalls),
+    static_cast<double>(now.branchStalls - last.branchStalls),
+    static_cast<double>(now.haltedStalls - last.haltedStalls),
+    static_cast<double>(now.loads - last.loads),
+    static_cast<double>(now.stores - last.stores)
+  };
+  for (auto type : UNIT_TYPES)
+  {
+    auto t = static_cast<std::size_t>(type);
+    row.push_back(ratio(static_cast<double>(
+      now.occupiedStationCycles[t] - last.occupiedStationCycles[t]), cycles));
+    row.push_back(ratio(static_cast<double>(
+      now.executeBusyCycles[t] - last.executeBusyCycles[t]), cycles));
+  }
+  last = now;
+
+  if (format == IntervalFormat::Csv)
+  {
+    for (std::size_t i = 0; i < row.size(); i++)
+    {
+      os << (i == 0 ? "" : ",");
+      // counts are printed in full rather than in scientific notation
+      if (row[i] == std::floor(row[i]))
+      {
+        os << static_cast<uint64_t>(row[i]);
+      }
+      else
+      {
+        os << row[i];
+      }
+    }
+    os << "\n";
+  }
+  else
+  {
+    for (std::size_t i = 0; i < row.size(); i++)
+    {
+      block[i].push_back(row[i]);
+    }
+    if (block[0].size() == BLOCK_ROWS)
+    {
+      flushBlock();
+    }
+  }
+}
+
+void IntervalStats::flushBlock()
+{
+  auto rows = static_cast<uint32_t>(block.empty() ? 0 : block[0].size());
+  if (rows == 0)
+  {
+    return;
+  }
+
+  os.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+  for (auto& values : block)
+  {
+    os.write(reinterpret_cast<const char*>(values.data()), 
+      values.size() * sizeof(double));
+    values.clear();
+  }
+}
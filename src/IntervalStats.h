@@ -0,0 +1,100 @@
+#ifndef __INTERVALSTATS_H__
+#define __INTERVALSTATS_H__
+
+#include "types.h"
+#include <vector>
+#include <string>
+#include <ostream>
+
+class PerformanceCounters;
+class IntervalStats;
+using IntervalStatsPtr = Pointer<IntervalStats>;
+
+/**
+ * What the length of an interval is measured in.
+ */
+enum class IntervalUnit
+{
+  Cycles,
+  Instructions
+};
+
+/**
+ * The file format written by IntervalStats.
+ */
+enum class IntervalFormat
+{
+  // a header row then one row per interval
+  Csv,
+  // "TMINTV01", a uint32 column count, then each column name terminated by 
+  // '\n', followed by blocks of a uint32 row count and then each column's 
+  // values for those rows as doubles, all in host byte order
+  Columnar
+};
+
+/**
+ * Streams a row of statistics for each interval of a run while it runs: IPC, 
+ * station and execute unit occupancy per functional unit, CDB utilization, 
+ * issue stalls and memory accesses.  Rows are the differences between 
+ * snapshots of the performance counters, so the counters are only read at 
+ * the end of each interval.
+ */
+class IntervalStats
+{
+private:
+  /**
+   * The counters read at the end of an interval.
+   */
+  struct Snapshot
+  {
+    uint64_t cycles;
+    uint64_t retired;
+    uint64_t cdbGrants;
+    uint64_t cdbRejections;
+    uint64_t stationsFullStalls;
+    uint64_t branchStalls;
+    uint64_t haltedStalls;
+    uint64_t loads;
+    uint64_t stores;
+    // per FunctionalUnitType
+    std::vector<uint64_t> occupiedStationCycles;
+    std::vector<uint64_t> executeBusyCycles;
+  };
+
+  std::ostream& os;
+  const IntervalUnit unit;
+  const uint64_t length;
+  const IntervalFormat format;
+  Snapshot last;
+  std::vector<std::string> columns;
+  // Columnar rows waiting to be written, column by column
+  std::vector<std::vector<double>> block;
+
+public:
+  /**
+   * Writes a row every length cycles or retired instructions.  os must 
+   * outlive this object.
+   */
+  IntervalStats(std::ostream& os, IntervalUnit unit, std::size_t length,
+    IntervalFormat format);
+  IntervalStats(const IntervalStats&) = delete;
+  IntervalStats& operator=(const IntervalStats&) = delete;
+
+  /**
+   * Called at the end of every cycle, writes a row when an interval is 
+   * complete.
+   */
+  void endCycle(const PerformanceCounters& counters);
+
+  /**
+   * Writes the final partial interval, if any, and any buffered rows.
+   */
+  void finish(const PerformanceCounters& counters);
+
+private:
+  Snapshot snapshot(const PerformanceCounters& counters) const;
+  void writeRow(const PerformanceCounters& counters);
+  void flushBlock();
+};
+
+#endif
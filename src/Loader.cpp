@@ -0,0 +1,162 @@
+#include "Loader.h"
+#include "log.h"
+#include "platform.h"
+#include "utility/stream_manip.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#if LU_COMPILER != LU_COMPILER_MSVC
+#include <dirent.h>
+#endif
+
+static const std::string TAG = "Loader";
+static const std::string FILE_EXT = ".hex";
+static const std::string HEX_DIGIT = "0123456789abcdefABCDEF";
+
+bool loadFromFile(Memory& mem, const std::string& filename,
+  SourceListing* source)
+{
+  bool hasFileExt = filename.length() >= FILE_EXT.length() 
+    && filename.compare(
+      filename.length() - FILE_EXT.length(),
+      FILE_EXT.length(), FILE_EXT
+      ) == 0;
+  if (!hasFileExt)
+  {
+    logger->error(TAG) << "Invalid file type " << filename;
+    return false;
+  }
+
+  std::ifstream file(filename.c_str(), std::ios::in);
+  if (!file)
+  {
+    logger->error(TAG, "Unable to open file " + filename);
+    return false;
+  }
+
+  logger->info(TAG, "Loading from file " + filename);
+  return loadFromStream(mem, file, source);
+}
+
+bool loadFromStream(Memory& mem, std::istream& input, SourceListing* source)
+{
+  std::size_t count = 0;
+  while (!input.eof())
+  {
+    std::string line;
+    std::getline(input, line);
+    //logger->verbose(TAG, "Read line \"" + line + "\"");
+
+    // strip comments
+    std::string comment;
+    auto commentIdx = line.find_first_of('#');
+    if (commentIdx != std::string::npos)
+    {
+      comment = line.substr(commentIdx + 1);
+      line.resize(commentIdx);
+    }
+
+    // relevant data in the line is
+    // [32 bit address]: [bytes...]
+    // A line without a colon is skipped
+    auto colon = line.find(':');
+    if (colon == std::string::npos)
+    {
+      continue;
+    }
+
+
+    Address addr;
+    {
+      // pull the address
+      std::istringstream is;
+      is.str(line.substr(0, colon));
+      is >> std::hex >> addr;
+      //logger->verbose(TAG) << "Address: " << util::hex<Address> << addr;
+    }
+    if (source)
+    {
+      (*source)[addr] = comment;
+    }
+
+    // find the hex data string after the colon
+    auto start = line.find_first_of(HEX_DIGIT, colon + 1);
+    if (start == std::string::npos)
+    {
+      // nothing to load
+      continue;
+    }
+    auto end = line.find_last_of(HEX_DIGIT);
+    std::istringstream is(line.substr(start, end - start + 1));
+    //logger->verbose(TAG, is.str());
+
+    ByteBuffer buffer;
+    buffer.reserve((end - start) / 2);
+    while (is.rdbuf()->in_avail() > 0)
+    {
+      std::string str;
+      std::stringstream temp;
+      // must use an integer type because streams will treat *any* char type 
+      // as an ascii character rather than an integer
+      UWord byte;
+
+      // pull 2 characters from the stream and convert them through a 
+      // temporary stream buffer
+      // why can't you pull them directly from the stream?  no idea, but if you 
+      // try to do that it ignores the width directive
+      is.width(2);
+      is >> str;
+      temp << str;
+      temp >> std::hex >> byte;
+      buffer.push_back(static_cast<Byte>(byte));
+      //logger->verbose(TAG) << "Byte: " << util::hex<Byte> << byte;
+    }
+
+    count += buffer.size();
+    mem.write(addr, buffer);
+    logger->verbose(TAG) << "Writing " << buffer.size() << " bytes to "
+      << util::hex<Address> << addr;
+  }
+
+  logger->verbose(TAG) << "Read in " << count << " bytes";
+  return true;
+}
+
+#if LU_COMPILER == LU_COMPILER_MSVC
+
+std::vector<std::string> findPrograms(const std::string&)
+{
+  // listing directories is not supported here
+  return std::vector<std::string>();
+}
+
+#else
+
+std::vector<std::string> findPrograms(const std::string& path)
+{
+  std::vector<std::string> names;
+
+  DIR* dir = opendir(path.c_str());
+  if (!dir)
+  {
+    return names;
+  }
+
+  while (struct dirent* entry = readdir(dir))
+  {
+    std::string name = entry->d_name;
+    if (name.size() > FILE_EXT.size() &&
+      name.compare(name.size() - FILE_EXT.size(), FILE_EXT.size(),
+        FILE_EXT) == 0)
+    {
+      names.push_back(name.substr(0, name.size() - FILE_EXT.size()));
+    }
+  }
+  closedir(dir);
+
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef __LOADER_H__
+#define __LOADER_H__
+
+#include "Memory.h"
+#include "PCProfile.h"
+#include <string>
+#include <istream>
+#include <vector>
+
+/**
+ * Populates memory with the contents of a .hex file.  If source is given, the 
+ * comment on each line is stored as the source text for its address.
+ */
+extern bool loadFromFile(Memory& mem, const std::string& filename,
+  SourceListing* source = nullptr);
+
+/**
+ * Populates memory with the .hex text read from input.
+ */
+extern bool loadFromStream(Memory& mem, std::istream& input,
+  SourceListing* source = nullptr);
+
+/**
+ * Lists the names of the .hex files in a directory, without the extension, 
+ * in sorted order.
+ */
+extern std::vector<std::string> findPrograms(const std::string& path);
+
+#endif
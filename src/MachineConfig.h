@@ -0,0 +1,68 @@
+#ifndef __MACHINECONFIG_H__
+#define __MACHINECONFIG_H__
+
+#include "types.h"
+#include "RegisterID.h"
+#include "instructions/instruction_types.h"
+
+// the configuration of the simulated machine
+
+// bytes of memory a program runs in
+static const std::size_t MEMORY_SIZE = 4 * 1024;
+
+static const std::size_t GPR_REGISTERS = 32;
+static const std::size_t FPR_REGISTERS = 32;
+
+static const std::size_t INTEGER_CYCLES = 1;
+static const std::size_t INTEGER_STATIONS = 8;
+static const std::size_t INTEGER_UNITS = 3;
+
+static const std::size_t TRAP_CYCLES = 1;
+static const std::size_t TRAP_STATIONS = 4;
+static const std::size_t TRAP_UNITS = 1;
+
+static const std::size_t BRANCH_CYCLES = 1;
+static const std::size_t BRANCH_STATIONS = 1;
+static const std::size_t BRANCH_UNITS = 1;
+
+static const std::size_t MEMORY_CYCLES = 2;
+static const std::size_t MEMORY_STATIONS = 8;
+static const std::size_t MEMORY_UNITS = 1;
+
+static const std::size_t FLOAT_CYCLES = 4;
+static const std::size_t FLOAT_STATIONS = 8;
+static const std::size_t FLOAT_UNITS = 2;
+
+// every unit type that has stations, in the order the reports list them
+static const FunctionalUnitType UNIT_TYPES[] = {
+  FunctionalUnitType::Integer,
+  FunctionalUnitType::Trap,
+  FunctionalUnitType::Branch,
+  FunctionalUnitType::Memory,
+  FunctionalUnitType::FloatingPoint
+};
+
+// size of a table indexed by FunctionalUnitType
+static const std::size_t NUM_UNIT_TYPES = 
+  static_cast<std::size_t>(FunctionalUnitType::FloatingPoint) + 1;
+
+/**
+ * Numbers the GPRs followed by the FPRs, for walking every register.  i must
+ * be below GPR_REGISTERS + FPR_REGISTERS.
+ */
+inline RegisterID registerAt(std::size_t i)
+{
+  return i < GPR_REGISTERS
+    ? RegisterID{ RegisterType::GPR, i }
+    : RegisterID{ RegisterType::FPR, i - GPR_REGISTERS };
+}
+
+/**
+ * num / den for the reports, or 0 when nothing was counted.
+ */
+inline double ratio(double num, double den)
+{
+  return den == 0 ? 0 : num / den;
+}
+
+#endif
@@ -12,8 +12,15 @@ static_assert(sizeof(float) == sizeof(UWord), "word size mismatch");
 
 static const std::string TAG = "memory";
 
+// small enough that the MEMORY_SIZE a program runs in spans 16 pages, so a
+// clear after a run that wrote a little zeroes a little
+static const std::size_t PAGE_BITS = 8;
+static const std::size_t PAGE_SIZE = std::size_t(1) << PAGE_BITS;
+
 Memory::Memory(UWord size)
-  : mem(size + (size % sizeof(Word)), 0)
+  : mem(size + (size % sizeof(Word)), 0),
+    touched((mem.size() + PAGE_SIZE - 1) >> PAGE_BITS, false),
+    touchedPages()
 {
   logger->verbose(TAG) 
     << "Initialized " << size + (size % sizeof(Word)) << " bytes";
@@ -26,7 +33,15 @@ std::size_t Memory::size() const
 
 void Memory::clear()
 {
-  std::fill(mem.begin(), mem.end(), 0);
+  for (auto page : touchedPages)
+  {
+    auto start = mem.begin() + (page << PAGE_BITS);
+    auto end = mem.end() - start > static_cast<std::ptrdiff_t>(PAGE_SIZE)
+      ? start + PAGE_SIZE : mem.end();
+    std::fill(start, end, 0);
+    touched[page] = false;
+  }
+  touchedPages.clear();
 }
 
 ByteBuffer Memory::read(Address addr, UWord bytes) const
@@ -108,6 +123,7 @@ void Memory::write(Address addr, const ByteBuffer& bytes)
     throw InvalidAddressException(addr, bytes.size(), size());
   }
 
+  touch(addr, bytes.size());
   std::copy(bytes.begin(), bytes.end(), mem.begin() + addr);
 }
 
@@ -118,6 +134,7 @@ void Memory::writeByte(Address addr, Byte b)
     throw InvalidAddressException(addr, sizeof(Byte), size());
   }
 
+  touch(addr, sizeof(Byte));
   mem[addr] = b;
 }
 
@@ -142,6 +159,7 @@ void Memory::writeUWord(Address addr, UWord uw)
 
   Data t;
   t.uw = uw;
+  touch(addr, sizeof(UWord));
   std::reverse_copy(t.b, t.b + sizeof(UWord), mem.begin() + addr);
 }
 
@@ -157,6 +175,41 @@ void Memory::writeFloat(Address addr, float f)
   writeUWord(addr, t.uw);
 }
 
+std::size_t Memory::accessibleSize() const
+{
+  return mem.size() > sizeof(UWord) ? mem.size() - sizeof(UWord) : 0;
+}
+
+ByteBuffer Memory::snapshot() const
+{
+  return read(0, static_cast<UWord>(accessibleSize()));
+}
+
+MemoryPtr Memory::copy() const
+{
+  MemoryPtr other(new Memory(static_cast<UWord>(mem.size())));
+  other->write(0, snapshot());
+  return other;
+}
+
+void Memory::touch(Address addr, std::size_t bytes)
+{
+  if (bytes == 0)
+  {
+    return;
+  }
+
+  auto last = (addr + bytes - 1) >> PAGE_BITS;
+  for (auto page = addr >> PAGE_BITS; page <= last; page++)
+  {
+    if (!touched[page])
+    {
+      touched[page] = true;
+      touchedPages.push_back(page);
+    }
+  }
+}
+
 void Memory::dump(Address addr, std::size_t bytes) const
 {
   if (addr + bytes >= size())
@@ -5,6 +5,10 @@
 #include "Exceptions.h"
 #include <string>
 #include <memory>
+#include <vector>
+
+class Memory;
+using MemoryPtr = std::shared_ptr<Memory>;
 
 /**
  * A byte accessible block of memory.
@@ -13,6 +17,9 @@ class Memory
 {
 private:
   ByteBuffer mem;
+  // pages written since the last clear, so clear() only zeroes those
+  std::vector<uint8_t> touched;
+  std::vector<std::size_t> touchedPages;
 
 public:
   /**
@@ -29,7 +36,8 @@ public:
   std::size_t size() const;
 
   /**
-   * Clears the full memory to zero.
+   * Clears the full memory to zero.  Only the pages written since the last 
+   * clear are zeroed, so clearing after a short program is cheap.
    */
   void clear();
 
@@ -58,8 +66,29 @@ public:
    * full words.
    */
   void dump(Address addr, std::size_t bytes) const;
-};
 
-using MemoryPtr = std::shared_ptr<Memory>;
+  /**
+   * The number of bytes a program can use.  The last word of memory is never 
+   * accessible.
+   */
+  std::size_t accessibleSize() const;
+
+  /**
+   * Returns the accessibleSize() bytes from address 0, which hold everything 
+   * a program can see.
+   */
+  ByteBuffer snapshot() const;
+
+  /**
+   * Creates a memory of the same size holding a snapshot of this one.
+   */
+  MemoryPtr copy() const;
+
+private:
+  /**
+   * Marks the pages holding bytes bytes from addr as written.
+   */
+  void touch(Address addr, std::size_t bytes);
+};
 
 #endif
@@ -0,0 +1,132 @@
+#include "Occupancy.h"
+#include "MachineConfig.h"
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+static const double PERCENTILES[] = { 0.5, 0.9, 0.99 };
+
+Histogram::Histogram(std::size_t maxValue)
+  : counts(maxValue + 1, 0),
+    samples(0)
+{
+}
+
+std::size_t Histogram::maxValue() const
+{
+  return counts.size() - 1;
+}
+
+Histogram::Counter Histogram::count(std::size_t value) const
+{
+  return value < counts.size() ? counts[value] : 0;
+}
+
+Histogram::Counter Histogram::total() const
+{
+  return samples;
+}
+
+double Histogram::mean() const
+{
+  double sum = 0;
+  for (std::size_t i = 0; i < counts.size(); i++)
+  {
+    sum += static_cast<double>(i) * counts[i];
+  }
+  return ratio(sum, static_cast<double>(samples));
+}
+
+std::size_t Histogram::percentile(double fraction) const
+{
+  Counter seen = 0;
+  for (std::size_t i = 0; i < counts.size(); i++)
+  {
+    seen += counts[i];
+    if (seen > 0 && seen >= fraction * samples)
+    {
+      return i;
+    }
+  }
+  return 0;
+}
+
+std::size_t Histogram::max() const
+{
+  for (std::size_t i = counts.size(); i > 0; i--)
+  {
+    if (counts[i - 1] > 0)
+    {
+      return i - 1;
+    }
+  }
+  return 0;
+}
+
+Occupancy::Occupancy(std::size_t totalStations)
+  : units(NUM_UNIT_TYPES),
+    cdbListeners(totalStations * 2),
+    cdbRequests(totalStations)
+{
+}
+
+void Occupancy::addFunctionalUnit(FunctionalUnitType type, 
+  std::size_t numStations, std::size_t numExecuteUnits)
+{
+  auto& unit = units[static_cast<std::size_t>(type)];
+  unit.stations = Histogram(numStations);
+  unit.executeUnits = Histogram(numExecuteUnits);
+}
+
+void Occupancy::writeReport(std::ostream& os) const
+{
+  os << std::dec << std::fixed << std::setfill(' ');
+  os << "Occupancy over " << cdbRequests.total() << " cycles" << std::endl;
+  os << std::left << std::setw(32) << "Resource" << std::right 
+    << std::setw(8) << "Mean" << std::setw(6) << "p50" << std::setw(6) 
+    << "p90" << std::setw(6) << "p99" << std::setw(6) << "Max" << std::endl;
+
+  auto row = [&](const std::string& name, const Histogram& histogram) {
+    os << std::left << std::setw(32) << name << std::right 
+      << std::setprecision(2) << std::setw(8) << histogram.mean();
+    for (auto fraction : PERCENTILES)
+    {
+      os << std::setw(6) << histogram.percentile(fraction);
+    }
+    os << std::setw(6) << histogram.max() << std::endl;
+
+    // the distribution, skipping values that were never seen
+    os << "   ";
+    for (std::size_t i = 0; i <= histogram.maxValue(); i++)
+    {
+      if (histogram.count(i) > 0)
+      {
+        os << " " << i << ":" << std::setprecision(1)
+          << 100 * ratio(static_cast<double>(histogram.count(i)), 
+            static_cast<double>(histogram.total())) << "%";
+      }
+    }
+    os << std::endl;
+  };
+
+  for (auto type : UNIT_TYPES)
+  {
+    const auto& unit = units[static_cast<std::size_t>(type)];
+    if (unit.stations.total() == 0)
+    {
+      continue;
+    }
+
+    std::ostringstream stations;
+    stations << type << " stations (of " << unit.stations.maxValue() << ")";
+    row(stations.str(), unit.stations);
+    std::ostringstream executeUnits;
+    executeUnits << type << " execute units (of " 
+      << unit.executeUnits.maxValue() << ")";
+    row(executeUnits.str(), unit.executeUnits);
+  }
+  row("CDB listeners", cdbListeners);
+  row("CDB write requests", cdbRequests);
+
+  os.unsetf(std::ios::floatfield);
+}
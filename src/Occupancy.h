@@ -0,0 +1,98 @@
+#ifndef __OCCUPANCY_H__
+#define __OCCUPANCY_H__
+
+#include "types.h"
+#include "instructions/instruction_types.h"
+#include <vector>
+#include <ostream>
+
+class Occupancy;
+using OccupancyPtr = Pointer<Occupancy>;
+
+/**
+ * Counts how many cycles a value was seen, with one bucket per value from 0 
+ * to a fixed maximum.  Larger values are counted in the last bucket.
+ */
+class Histogram
+{
+public:
+  using Counter = uint64_t;
+
+private:
+  std::vector<Counter> counts;
+  Counter samples;
+
+public:
+  explicit Histogram(std::size_t maxValue = 0);
+
+  void add(std::size_t value)
+  {
+    counts[value < counts.size() ? value : counts.size() - 1]++;
+    samples++;
+  }
+
+  std::size_t maxValue() const;
+  Counter count(std::size_t value) const;
+  Counter total() const;
+  double mean() const;
+
+  /**
+   * The smallest value that at least fraction of the samples do not exceed.
+   */
+  std::size_t percentile(double fraction) const;
+
+  /**
+   * The largest value seen.
+   */
+  std::size_t max() const;
+};
+
+/**
+ * Per cycle distributions of the resources that limit issue: occupied 
+ * stations and busy execute units of each functional unit, stations 
+ * listening on the CDB, and simultaneous CDB write requests.  The requests 
+ * beyond the first are the writes that lost arbitration.
+ */
+class Occupancy
+{
+private:
+  /**
+   * The histograms of a single functional unit.
+   */
+  struct Unit
+  {
+    Histogram stations;
+    Histogram executeUnits;
+  };
+
+  // indexed by FunctionalUnitType
+  std::vector<Unit> units;
+
+public:
+  Histogram cdbListeners;
+  Histogram cdbRequests;
+
+  /**
+   * Stations can listen on the CDB for both operands, so there are at most 
+   * twice as many listeners as stations, and at most one write request per 
+   * station.
+   */
+  explicit Occupancy(std::size_t totalStations);
+  Occupancy(const Occupancy&) = delete;
+  Occupancy& operator=(const Occupancy&) = delete;
+
+  void addFunctionalUnit(FunctionalUnitType type, std::size_t numStations, 
+    std::size_t numExecuteUnits);
+
+  void addCycle(FunctionalUnitType type, std::size_t stationsUsed, 
+    std::size_t executeUnitsUsed)
+  {
+    auto& unit = units[static_cast<std::size_t>(type)];
+    unit.stations.add(stationsUsed);
+    unit.executeUnits.add(executeUnitsUsed);
+  }
+
+  void writeReport(std::ostream& os) const;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "PCProfile.h"
+#include "utility/stream_manip.h"
+#include <algorithm>
+#include <iomanip>
+#include <cctype>
+#include <sstream>
+
+/**
+ * Extracts the label from a line of source, or returns an empty string.
+ */
+static std::string findLabel(const std::string& line)
+{
+  auto start = line.find_first_not_of(" \t");
+  if (start == std::string::npos 
+    || !(std::isalpha(line[start]) || line[start] == '_'))
+  {
+    return "";
+  }
+
+  auto end = start;
+  while (end < line.size() && (std::isalnum(line[end]) || line[end] == '_'))
+  {
+    end++;
+  }
+  if (end >= line.size() || line[end] != ':')
+  {
+    return "";
+  }
+
+  return line.substr(start, end - start);
+}
+
+static std::string trim(const std::string& line)
+{
+  auto start = line.find_first_not_of(" \t");
+  auto end = line.find_last_not_of(" \t\r");
+  return start == std::string::npos ? "" : line.substr(start, end - start + 1);
+}
+
+PCCounters::Counter PCCounters::total() const
+{
+  return issueCycles + operandWaitCycles + executeWaitCycles + cdbWaitCycles;
+}
+
+PCProfile::PCProfile(std::size_t memorySize)
+  : memorySize(memorySize),
+    counters(memorySize / sizeof(UWord) + 1, PCCounters())
+{
+}
+
+void PCProfile::writeReport(std::ostream& os, const SourceListing& source,
+  std::size_t numHottest) const
+{
+  // every address that is in the source or was reached
+  SourceListing listing(source);
+  for (std::size_t i = 0; i < counters.size(); i++)
+  {
+    Address addr = static_cast<Address>(i * sizeof(UWord));
+    if (reached(addr) && listing.find(addr) == listing.end())
+    {
+      listing[addr] = "";
+    }
+  }
+
+  os << std::dec << "Cycle attribution by PC" << std::endl;
+  os << "Address   Issued   Issue    Full  Branch    Halt Operand Execute"
+    << "     CDB  Source" << std::endl;
+  for (const auto& line : listing)
+  {
+    os << util::hex<Address> << line.first << std::dec;
+    if (line.first % sizeof(UWord) == 0 && reached(line.first))
+    {
+      const auto& pc = at(line.first);
+      os << std::setfill(' ')
+        << " " << std::setw(7) << pc.issued
+        << " " << std::setw(7) << pc.issueCycles
+        << " " << std::setw(7) << pc.stationsFullStalls
+        << " " << std::setw(7) << pc.branchStalls
+        << " " << std::setw(7) << pc.haltedStalls
+        << " " << std::setw(7) << pc.operandWaitCycles
+        << " " << std::setw(7) << pc.executeWaitCycles
+        << " " << std::setw(7) << pc.cdbWaitCycles;
+    }
+    else
+    {
+      os << std::string(8 * 8, ' ');
+    }
+    os << "  " << trim(line.second) << std::endl;
+  }
+
+  // nearest preceding label for each address
+  std::map<Address, std::string> symbols;
+  for (const auto& line : source)
+  {
+    auto label = findLabel(line.second);
+    if (!label.empty())
+    {
+      symbols[line.first] = label;
+    }
+  }
+
+  std::vector<Address> hottest;
+  for (std::size_t i = 0; i < counters.size(); i++)
+  {
+    if (counters[i].total() > 0)
+    {
+      hottest.push_back(static_cast<Address>(i * sizeof(UWord)));
+    }
+  }
+  std::stable_sort(hottest.begin(), hottest.end(), 
+    [&](Address lhs, Address rhs) {
+      return at(lhs).total() > at(rhs).total();
+    });
+  if (hottest.size() > numHottest)
+  {
+    hottest.resize(numHottest);
+  }
+
+  os << std::endl << "Hottest PCs" << std::endl;
+  os << "Rank  Address   Symbol              Cycles  Source" << std::endl;
+  std::size_t rank = 1;
+  for (auto addr : hottest)
+  {
+    std::ostringstream symbol;
+    auto itr = symbols.upper_bound(addr);
+    if (itr != symbols.begin())
+    {
+      --itr;
+      symbol << itr->second << "+" << std::dec << (addr - itr->first);
+    }
+
+    auto src = source.find(addr);
+    os << std::dec << std::setfill(' ') << std::setw(4) << rank++ << "  " 
+      << util::hex<Address> << addr << std::setfill(' ') << "  " 
+      << std::left << std::setw(18) << symbol.str() << std::right 
+      << std::dec << std::setw(8) << at(addr).total() << "  "
+      << (src == source.end() ? "" : trim(src->second)) << std::endl;
+  }
+}
+
+bool PCProfile::reached(Address addr) const
+{
+  return at(addr).total() > 0;
+}
@@ -0,0 +1,99 @@
+#ifndef __PCPROFILE_H__
+#define __PCPROFILE_H__
+
+#include "types.h"
+#include "Exceptions.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <ostream>
+
+class PCProfile;
+using PCProfilePtr = Pointer<PCProfile>;
+
+/**
+ * Source text for each address of a program, taken from the comments of a 
+ * .hex file.
+ */
+using SourceListing = std::map<Address, std::string>;
+
+/**
+ * The cycles attributed to a single instruction address.
+ */
+struct PCCounters
+{
+  using Counter = uint64_t;
+
+  // times the instruction was issued
+  Counter issued;
+  // cycles the issue stage spent on this address, including the stalls below
+  Counter issueCycles;
+  Counter stationsFullStalls;
+  // cycles issue waited for this branch to resolve
+  Counter branchStalls;
+  // cycles spent draining the pipeline after this halt
+  Counter haltedStalls;
+  // station cycles spent waiting for an operand from the CDB
+  Counter operandWaitCycles;
+  // station cycles spent ready to execute without a free execute unit
+  Counter executeWaitCycles;
+  // cycles spent losing CDB arbitration
+  Counter cdbWaitCycles;
+
+  /**
+   * The total cycles attributed to the address, used to rank hot addresses.
+   */
+  Counter total() const;
+};
+
+/**
+ * Attributes simulated cycles and stalls to the address of the instruction 
+ * responsible for them.  Every cycle is charged to the address at the issue 
+ * stage, and stations add the cycles they spend waiting to the address of 
+ * their instruction.
+ */
+class PCProfile
+{
+private:
+  std::size_t memorySize;
+  // indexed by word address
+  std::vector<PCCounters> counters;
+
+public:
+  explicit PCProfile(std::size_t memorySize);
+  PCProfile(const PCProfile&) = delete;
+  PCProfile& operator=(const PCProfile&) = delete;
+
+  /**
+   * The counters of addr.  Throws InvalidAddressException if addr is outside 
+   * memory, as fetching from it would.
+   */
+  PCCounters& at(Address addr)
+  {
+    return counters[indexOf(addr)];
+  }
+  const PCCounters& at(Address addr) const
+  {
+    return counters[indexOf(addr)];
+  }
+
+  /**
+   * Writes the program listing annotated with the counters of each address, 
+   * followed by the hottest addresses.
+   */
+  void writeReport(std::ostream& os, const SourceListing& source,
+    std::size_t numHottest) const;
+
+private:
+  std::size_t indexOf(Address addr) const
+  {
+    if (addr >= memorySize)
+    {
+      throw InvalidAddressException(addr, sizeof(UWord), memorySize);
+    }
+    return addr / sizeof(UWord);
+  }
+  bool reached(Address addr) const;
+};
+
+#endif
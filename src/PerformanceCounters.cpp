@@ -0,0 +1,260 @@
+#include "PerformanceCounters.h"
+#include "MachineConfig.h"
+#include <iomanip>
+#include <cassert>
+#include <algorithm>
+
+// every counter that only grows, for snapshot() and advance()
+static PerformanceCounters::Counter PerformanceCounters::* const 
+  MACHINE_COUNTERS[] = {
+  &PerformanceCounters::cycles,
+  &PerformanceCounters::branchStalls,
+  &PerformanceCounters::haltedStalls,
+  &PerformanceCounters::cdbGrants,
+  &PerformanceCounters::cdbRejections,
+  &PerformanceCounters::loads,
+  &PerformanceCounters::stores
+};
+
+static FunctionalUnitCounters::Counter FunctionalUnitCounters::* const 
+  UNIT_COUNTERS[] = {
+  &FunctionalUnitCounters::issued,
+  &FunctionalUnitCounters::retired,
+  &FunctionalUnitCounters::stationsFullStalls,
+  &FunctionalUnitCounters::occupiedStationCycles,
+  &FunctionalUnitCounters::executeBusyCycles
+};
+
+PerformanceCounters::PerformanceCounters()
+  : cycles(0),
+    branchStalls(0),
+    haltedStalls(0),
+    cdbGrants(0),
+    cdbRejections(0),
+    loads(0),
+    stores(0),
+    pcProfile(nullptr),
+    cpiStack(nullptr),
+    pipelineTrace(nullptr),
+    occupancy(nullptr),
+    intervalStats(nullptr),
+    units(NUM_UNIT_TYPES)
+{
+  for (auto& unit : units)
+  {
+    unit = FunctionalUnitCounters{ 0, 0, 0, 0, 0, 0, 0, {} };
+  }
+}
+
+FunctionalUnitCounters& PerformanceCounters::addFunctionalUnit(
+  FunctionalUnitType type, std::size_t numStations, 
+  std::size_t numExecuteUnits)
+{
+  auto& unit = units[static_cast<std::size_t>(type)];
+  unit.numStations = numStations;
+  unit.numExecuteUnits = numExecuteUnits;
+  unit.waitingCycles.assign(numStations, 0);
+  return unit;
+}
+
+const FunctionalUnitCounters& PerformanceCounters::getFunctionalUnit(
+  FunctionalUnitType type) const
+{
+  return units[static_cast<std::size_t>(type)];
+}
+
+void PerformanceCounters::reset()
+{
+  for (auto counter : MACHINE_COUNTERS)
+  {
+    this->*counter = 0;
+  }
+  pcProfile = nullptr;
+  cpiStack = nullptr;
+  pipelineTrace = nullptr;
+  occupancy = nullptr;
+  intervalStats = nullptr;
+  for (auto& unit : units)
+  {
+    for (auto counter : UNIT_COUNTERS)
+    {
+      unit.*counter = 0;
+    }
+    std::fill(unit.waitingCycles.begin(), unit.waitingCycles.end(), 0);
+  }
+}
+
+std::vector<PerformanceCounters::Counter> PerformanceCounters::snapshot() 
+  const
+{
+  std::vector<Counter> values;
+  for (auto counter : MACHINE_COUNTERS)
+  {
+    values.push_back(this->*counter);
+  }
+  for (const auto& unit : units)
+  {
+    for (auto counter : UNIT_COUNTERS)
+    {
+      values.push_back(unit.*counter);
+    }
+    values.insert(values.end(), unit.waitingCycles.begin(), 
+      unit.waitingCycles.end());
+  }
+  return values;
+}
+
+void PerformanceCounters::advance(const std::vector<Counter>& start,
+  const std::vector<Counter>& end, Counter times)
+{
+  assert(start.size() == end.size());
+  std::size_t i = 0;
+  for (auto counter : MACHINE_COUNTERS)
+  {
+    this->*counter += (end[i] - start[i]) * times;
+    i++;
+  }
+  for (auto& unit : units)
+  {
+    for (auto counter : UNIT_COUNTERS)
+    {
+      unit.*counter += (end[i] - start[i]) * times;
+      i++;
+    }
+    for (auto& waiting : unit.waitingCycles)
+    {
+      waiting += (end[i] - start[i]) * times;
+      i++;
+    }
+  }
+  assert(i == end.size());
+}
+
+PerformanceCounters::Counter PerformanceCounters::issued() const
+{
+  Counter total = 0;
+  for (const auto& unit : units)
+  {
+    total += unit.issued;
+  }
+  return total;
+}
+
+PerformanceCounters::Counter PerformanceCounters::retired() const
+{
+  Counter total = 0;
+  for (const auto& unit : units)
+  {
+    total += unit.retired;
+  }
+  return total;
+}
+
+PerformanceCounters::Counter PerformanceCounters::stationsFullStalls() const
+{
+  Counter total = 0;
+  for (const auto& unit : units)
+  {
+    total += unit.stationsFullStalls;
+  }
+  return total;
+}
+
+double PerformanceCounters::ipc() const
+{
+  return ratio(static_cast<double>(retired()), static_cast<double>(cycles));
+}
+
+void PerformanceCounters::writeText(std::ostream& os) const
+{
+  os << std::dec << std::fixed << std::setprecision(3);
+  os << "Cycles: " << cycles << "\n";
+  os << "Instructions issued: " << issued() << "\n";
+  os << "Instructions retired: " << retired() << "\n";
+  os << "IPC: " << ipc() << "\n";
+  os << "Issue stalls: " << stationsFullStalls() << " stations full, " 
+    << branchStalls << " branch, " << haltedStalls << " halted\n";
+  os << "CDB: " << cdbGrants << " grants, " << cdbRejections 
+    << " rejections\n";
+  os << "Memory accesses: " << loads << " loads, " << stores << " stores\n";
+
+  for (auto type : UNIT_TYPES)
+  {
+    const auto& unit = getFunctionalUnit(type);
+    if (unit.numStations == 0)
+    {
+      continue;
+    }
+
+    os << type << " Functional Unit\n";
+    os << "\tIssued: " << unit.issued << ", retired: " << unit.retired 
+      << "\n";
+    os << "\tStations full stalls: " << unit.stationsFullStalls << "\n";
+    os << "\tAverage stations in use: " << ratio(
+      static_cast<double>(unit.occupiedStationCycles), 
+      static_cast<double>(cycles)) << " of " << unit.numStations << "\n";
+    os << "\tExecute unit busy cycles: " << unit.executeBusyCycles 
+      << " (" << 100 * ratio(static_cast<double>(unit.executeBusyCycles), 
+        static_cast<double>(cycles * unit.numExecuteUnits)) 
+      << "% utilization)\n";
+    os << "\tOperand wait cycles:";
+    for (std::size_t i = 0; i < unit.waitingCycles.size(); i++)
+    {
+      os << " " << type << i << "=" << unit.waitingCycles[i];
+    }
+    os << "\n";
+  }
+
+  os.unsetf(std::ios::floatfield);
+}
+
+void PerformanceCounters::writeJson(std::ostream& os) const
+{
+  os << std::dec << std::fixed << std::setprecision(6);
+  os << "{\n";
+  os << "  \"cycles\": " << cycles << ",\n";
+  os << "  \"issued\": " << issued() << ",\n";
+  os << "  \"retired\": " << retired() << ",\n";
+  os << "  \"ipc\": " << ipc() << ",\n";
+  os << "  \"issueStalls\": { \"stationsFull\": " << stationsFullStalls()
+    << ", \"branch\": " << branchStalls << ", \"halted\": " << haltedStalls
+    << " },\n";
+  os << "  \"cdb\": { \"grants\": " << cdbGrants << ", \"rejections\": " 
+    << cdbRejections << " },\n";
+  os << "  \"memory\": { \"loads\": " << loads << ", \"stores\": " << stores
+    << " },\n";
+  os << "  \"functionalUnits\": {";
+
+  bool first = true;
+  for (auto type : UNIT_TYPES)
+  {
+    const auto& unit = getFunctionalUnit(type);
+    if (unit.numStations == 0)
+    {
+      continue;
+    }
+
+    os << (first ? "\n" : ",\n");
+    first = false;
+    os << "    \"" << type << "\": {\n";
+    os << "      \"stations\": " << unit.numStations << ",\n";
+    os << "      \"executeUnits\": " << unit.numExecuteUnits << ",\n";
+    os << "      \"issued\": " << unit.issued << ",\n";
+    os << "      \"retired\": " << unit.retired << ",\n";
+    os << "      \"stationsFullStalls\": " << unit.stationsFullStalls << ",\n";
+    os << "      \"occupiedStationCycles\": " << unit.occupiedStationCycles 
+      << ",\n";
+    os << "      \"executeBusyCycles\": " << unit.executeBusyCycles << ",\n";
+    os << "      \"waitingCycles\": [";
+    for (std::size_t i = 0; i < unit.waitingCycles.size(); i++)
+    {
+      os << (i == 0 ? "" : ", ") << unit.waitingCycles[i];
+    }
+    os << "]\n";
+    os << "    }";
+  }
+
+  os << "\n  }\n";
+  os << "}\n";
+  os.unsetf(std::ios::floatfield);
+}
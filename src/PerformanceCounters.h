@@ -0,0 +1,119 @@
+#ifndef __PERFORMANCECOUNTERS_H__
+#define __PERFORMANCECOUNTERS_H__
+
+#include "types.h"
+#include "instructions/instruction_types.h"
+#include "PCProfile.h"
+#include "CPIStack.h"
+#include "PipelineTrace.h"
+#include "Occupancy.h"
+#include "IntervalStats.h"
+#include <vector>
+#include <ostream>
+
+class PerformanceCounters;
+using PerformanceCountersPtr = Pointer<PerformanceCounters>;
+
+/**
+ * Event counts for a single functional unit.
+ */
+struct FunctionalUnitCounters
+{
+  using Counter = uint64_t;
+
+  std::size_t numStations;
+  std::size_t numExecuteUnits;
+
+  Counter issued;
+  Counter retired;
+  // cycles the issue stage stalled because every station was busy
+  Counter stationsFullStalls;
+  // sum over cycles of the stations in use
+  Counter occupiedStationCycles;
+  // sum over cycles of the execute units in use
+  Counter executeBusyCycles;
+  // cycles each station spent waiting for operands, counted when they 
+  // arrive
+  std::vector<Counter> waitingCycles;
+};
+
+/**
+ * Counters updated by the processor components as a program runs.  Updates 
+ * are plain increments of public fields so they can stay enabled at all 
+ * times.
+ */
+class PerformanceCounters
+{
+public:
+  using Counter = FunctionalUnitCounters::Counter;
+
+  Counter cycles;
+  // cycles the issue stage waited for a branch to resolve
+  Counter branchStalls;
+  // cycles the issue stage was idle because the program halted
+  Counter haltedStalls;
+  // CommonDataBus writes that were committed / lost arbitration
+  Counter cdbGrants;
+  Counter cdbRejections;
+  // data memory accesses by loads and stores
+  Counter loads;
+  Counter stores;
+
+  // per address attribution, only collected when set
+  PCProfilePtr pcProfile;
+  // cycle breakdown, only collected when set
+  CPIStackPtr cpiStack;
+  // instruction lifecycles, only collected when set
+  PipelineTracePtr pipelineTrace;
+  // per cycle resource distributions, only collected when set
+  OccupancyPtr occupancy;
+  // statistics per interval, only collected when set
+  IntervalStatsPtr intervalStats;
+
+private:
+  // indexed by FunctionalUnitType, never resized so references stay valid
+  std::vector<FunctionalUnitCounters> units;
+
+public:
+  PerformanceCounters();
+  PerformanceCounters(const PerformanceCounters&) = delete;
+  PerformanceCounters& operator=(const PerformanceCounters&) = delete;
+
+  /**
+   * Sets up the counters for a functional unit and returns them.  The 
+   * reference remains valid for the life of this object.
+   */
+  FunctionalUnitCounters& addFunctionalUnit(FunctionalUnitType type, 
+    std::size_t numStations, std::size_t numExecuteUnits);
+  const FunctionalUnitCounters& getFunctionalUnit(FunctionalUnitType type) 
+    const;
+
+  /**
+   * Zeroes every counter and drops the optional collectors.  The functional 
+   * units stay set up.
+   */
+  void reset();
+
+  /**
+   * The value of every counter above, in a fixed order.  The optional 
+   * collectors are not included.
+   */
+  std::vector<Counter> snapshot() const;
+
+  /**
+   * Adds times the change in every counter from start to end, both taken by 
+   * snapshot(), as if the cycles between them repeated times more.
+   */
+  void advance(const std::vector<Counter>& start, 
+    const std::vector<Counter>& end, Counter times);
+
+  Counter issued() const;
+  Counter retired() const;
+  Counter stationsFullStalls() const;
+  double ipc() const;
+
+  void writeText(std::ostream& os) const;
+  void writeJson(std::ostream& os) const;
+};
+
+#endif
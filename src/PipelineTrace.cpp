@@ -0,0 +1,249 @@
+#include "PipelineTrace.h"
+#include "utility/stream_manip.h"
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+/**
+ * The source text of an address, without tabs or newlines.
+ */
+static std::string label(Address address, const SourceListing& source)
+{
+  std::ostringstream os;
+  os << util::hex<Address> << address << std::dec;
+  auto it = source.find(address);
+  if (it != source.end())
+  {
+    os << ": " << it->second;
+  }
+
+  auto result = os.str();
+  std::replace(result.begin(), result.end(), '\t', ' ');
+  std::replace(result.begin(), result.end(), '\n', ' ');
+  result.erase(result.find_last_not_of(' ') + 1);
+  return result;
+}
+
+static std::string jsonEscape(const std::string& s)
+{
+  std::string result;
+  result.reserve(s.size());
+  for (auto c : s)
+  {
+    if (c == '"' || c == '\\')
+    {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result;
+}
+
+static uint32_t clockOf(const PipelineRecord& record, PipelineEvent event)
+{
+  return record.clocks[static_cast<std::size_t>(event)];
+}
+
+PipelineTrace::PipelineTrace(std::size_t capacity)
+  : records(capacity > 0 ? capacity : 1),
+    nextSequence(0),
+    clock(0)
+{
+  for (auto& record : records)
+  {
+    record.sequence = NO_SEQUENCE;
+  }
+}
+
+void PipelineTrace::setClock(std::size_t clock)
+{
+  this->clock = static_cast<uint32_t>(clock);
+}
+
+uint64_t PipelineTrace::begin(const ReservationStationID& station, 
+  Address address, std::size_t clock)
+{
+  auto sequence = nextSequence++;
+  auto& record = records[sequence % records.size()];
+  record.sequence = sequence;
+  record.address = address;
+  record.type = station.type;
+  record.station = static_cast<uint32_t>(station.index);
+  std::fill(std::begin(record.clocks), std::end(record.clocks), 0);
+  record.clocks[static_cast<std::size_t>(PipelineEvent::Issue)] = 
+    static_cast<uint32_t>(clock);
+  return sequence;
+}
+
+void PipelineTrace::mark(uint64_t sequence, PipelineEvent event)
+{
+  auto& record = records[sequence % records.size()];
+  if (record.sequence == sequence)
+  {
+    record.clocks[static_cast<std::size_t>(event)] = clock;
+  }
+}
+
+uint64_t PipelineTrace::issued() const
+{
+  return nextSequence;
+}
+
+void PipelineTrace::writeKanata(std::ostream& os, 
+  const SourceListing& source) const
+{
+  // stage transitions, each closing the previous stage of the instruction
+  struct Transition
+  {
+    uint32_t clock;
+    std::size_t id;
+    const char* from;
+    const char* to;
+  };
+
+  auto instructions = ordered();
+  std::vector<Transition> transitions;
+  transitions.reserve(instructions.size() * 5);
+  for (std::size_t id = 0; id < instructions.size(); id++)
+  {
+    const auto& record = *instructions[id];
+    const char* stage = nullptr;
+    auto add = [&](uint32_t clock, const char* to) {
+      if (clock > 0)
+      {
+        transitions.push_back({ clock, id, stage, to });
+        stage = to;
+      }
+    };
+
+    add(clockOf(record, PipelineEvent::Issue), "Is");
+    add(clockOf(record, PipelineEvent::ExecuteStart), "Ex");
+    auto complete = clockOf(record, PipelineEvent::ExecuteComplete);
+    auto request = clockOf(record, PipelineEvent::WriteRequest);
+    if (complete > 0 && complete + 1 < request)
+    {
+      add(complete + 1, "Cw");
+    }
+    add(request, "Wb");
+    add(clockOf(record, PipelineEvent::Retire), nullptr);
+  }
+  std::stable_sort(transitions.begin(), transitions.end(),
+    [](const Transition& lhs, const Transition& rhs) {
+      return lhs.clock < rhs.clock;
+    });
+
+  os << std::dec << "Kanata\t0004\n";
+  uint32_t cycle = transitions.empty() ? 0 : transitions.front().clock;
+  os << "C=\t" << cycle << "\n";
+
+  std::size_t retired = 0;
+  for (const auto& t : transitions)
+  {
+    if (t.clock != cycle)
+    {
+      os << "C\t" << t.clock - cycle << "\n";
+      cycle = t.clock;
+    }
+
+    if (t.from == nullptr)
+    {
+      const auto& record = *instructions[t.id];
+      os << "I\t" << t.id << "\t" << record.sequence << "\t0\n";
+      os << "L\t" << t.id << "\t0\t" << label(record.address, source) << "\n";
+      os << "L\t" << t.id << "\t1\t" 
+        << ReservationStationID{ record.type, record.station } << "\n";
+    }
+    else
+    {
+      os << "E\t" << t.id << "\t0\t" << t.from << "\n";
+    }
+
+    if (t.to != nullptr)
+    {
+      os << "S\t" << t.id << "\t0\t" << t.to << "\n";
+    }
+    else
+    {
+      os << "R\t" << t.id << "\t" << retired++ << "\t0\n";
+    }
+  }
+}
+
+void PipelineTrace::writeChromeTrace(std::ostream& os, 
+  const SourceListing& source) const
+{
+  auto instructions = ordered();
+  bool first = true;
+  auto separator = [&]() -> std::ostream& {
+    os << (first ? "\n  " : ",\n  ");
+    first = false;
+    return os;
+  };
+
+  os << std::dec << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+  // name the process of each unit and the thread of each station
+  std::vector<ReservationStationID> named;
+  for (auto record : instructions)
+  {
+    ReservationStationID id = { record->type, record->station };
+    if (std::find(named.begin(), named.end(), id) != named.end())
+    {
+      continue;
+    }
+    auto pid = static_cast<int>(record->type);
+    bool newUnit = std::none_of(named.begin(), named.end(), 
+      [&](const ReservationStationID& n) { return n.type == id.type; });
+    if (newUnit)
+    {
+      separator() << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " 
+        << pid << ", \"args\": {\"name\": \"" << id.type << "\"}}";
+    }
+    separator() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " 
+      << pid << ", \"tid\": " << id.index << ", \"args\": {\"name\": \"" 
+      << id << "\"}}";
+    named.push_back(id);
+  }
+
+  for (auto record : instructions)
+  {
+    auto name = jsonEscape(label(record->address, source));
+    auto phase = [&](const char* category, uint32_t begin, uint32_t end) {
+      if (begin == 0 || end <= begin)
+      {
+        return;
+      }
+      separator() << "{\"name\": \"" << name << "\", \"cat\": \"" 
+        << category << "\", \"ph\": \"X\", \"ts\": " << begin 
+        << ", \"dur\": " << end - begin << ", \"pid\": " 
+        << static_cast<int>(record->type) << ", \"tid\": " 
+        << record->station << ", \"args\": {\"sequence\": " 
+        << record->sequence << "}}";
+    };
+
+    auto issue = clockOf(*record, PipelineEvent::Issue);
+    auto start = clockOf(*record, PipelineEvent::ExecuteStart);
+    auto complete = clockOf(*record, PipelineEvent::ExecuteComplete);
+    auto request = clockOf(*record, PipelineEvent::WriteRequest);
+    auto grant = clockOf(*record, PipelineEvent::WriteGrant);
+    phase("Issued", issue, start);
+    phase("Execute", start, complete + 1);
+    phase("Complete", complete + 1, request);
+    phase("Write", request, grant + 1);
+  }
+
+  os << "\n]}" << std::endl;
+}
+
+std::vector<const PipelineRecord*> PipelineTrace::ordered() const
+{
+  std::vector<const PipelineRecord*> result;
+  auto count = std::min<uint64_t>(nextSequence, records.size());
+  result.reserve(static_cast<std::size_t>(count));
+  for (auto sequence = nextSequence - count; sequence < nextSequence; 
+    sequence++)
+  {
+    result.push_back(&records[sequence % records.size()]);
+  }
+  return result;
+}
@@ -0,0 +1,106 @@
+#ifndef __PIPELINETRACE_H__
+#define __PIPELINETRACE_H__
+
+#include "types.h"
+#include "ReservationStationID.h"
+#include "PCProfile.h"
+#include <vector>
+#include <ostream>
+
+class PipelineTrace;
+using PipelineTracePtr = Pointer<PipelineTrace>;
+
+/**
+ * The points in an instruction's life recorded by a PipelineTrace.
+ */
+enum class PipelineEvent : uint8_t
+{
+  Issue,
+  ExecuteStart,
+  ExecuteComplete,
+  WriteRequest,
+  WriteGrant,
+  Retire
+};
+
+/**
+ * The clock of each PipelineEvent of one instruction, 0 when the event has 
+ * not happened.
+ */
+struct PipelineRecord
+{
+  static const std::size_t NUM_EVENTS = 
+    static_cast<std::size_t>(PipelineEvent::Retire) + 1;
+
+  uint64_t sequence;
+  Address address;
+  FunctionalUnitType type;
+  uint32_t station;
+  uint32_t clocks[NUM_EVENTS];
+};
+
+/**
+ * Records the lifecycle of the most recently issued instructions in a 
+ * preallocated ring buffer, for export to pipeline visualizers.
+ */
+class PipelineTrace
+{
+public:
+  static const uint64_t NO_SEQUENCE = ~0ull;
+
+private:
+  std::vector<PipelineRecord> records;
+  uint64_t nextSequence;
+  uint32_t clock;
+
+public:
+  /**
+   * Keeps the last capacity instructions.
+   */
+  explicit PipelineTrace(std::size_t capacity);
+  PipelineTrace(const PipelineTrace&) = delete;
+  PipelineTrace& operator=(const PipelineTrace&) = delete;
+
+  /**
+   * Sets the clock used by mark().
+   */
+  void setClock(std::size_t clock);
+
+  /**
+   * Starts a record for an instruction issued to station at clock, returning 
+   * the sequence number used to mark its later events.
+   */
+  uint64_t begin(const ReservationStationID& station, Address address, 
+    std::size_t clock);
+
+  /**
+   * Records an event at the current clock.  Ignored if the instruction's 
+   * record has been overwritten.
+   */
+  void mark(uint64_t sequence, PipelineEvent event);
+
+  /**
+   * The number of instructions issued, including those no longer recorded.
+   */
+  uint64_t issued() const;
+
+  /**
+   * Writes the recorded instructions in the Kanata log format.
+   */
+  void writeKanata(std::ostream& os, const SourceListing& source) const;
+
+  /**
+   * Writes the recorded instructions as Chrome trace event JSON, one cycle 
+   * per microsecond, with a process per functional unit and a thread per 
+   * station.
+   */
+  void writeChromeTrace(std::ostream& os, const SourceListing& source) const;
+
+private:
+  /**
+   * The recorded instructions, oldest first.
+   */
+  std::vector<const PipelineRecord*> ordered() const;
+};
+
+#endif
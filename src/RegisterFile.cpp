@@ -2,18 +2,13 @@
 #include "Exceptions.h"
 
 RegisterFile::RegisterFile(std::size_t numGPR, std::size_t numFPR)
-  : registers()
+  : numGPR(numGPR),
+    numFPR(numFPR),
+    registers(numGPR + numFPR)
 {
-  Data data = { 0 };
-  for (std::size_t i = 0; i < numGPR; ++i)
+  for (auto& data : registers)
   {
-    RegisterID gpr = { RegisterType::GPR, i };
-    registers[gpr] = data;
-  }
-  for (std::size_t i = 0; i < numFPR; ++i)
-  {
-    RegisterID fpr = { RegisterType::FPR, i };
-    registers[fpr] = data;
+    data.uw = 0;
   }
 }
 
@@ -25,13 +20,7 @@ Data RegisterFile::read(const RegisterID& reg) const
     return data;
   }
 
-  auto itr = registers.find(reg);
-  if (itr == registers.end())
-  {
-    throw InvalidRegisterException(reg);
-  }
-
-  return itr->second;
+  return registers[indexOf(reg)];
 }
 
 void RegisterFile::write(const RegisterID& reg, Data data)
@@ -41,11 +30,27 @@ void RegisterFile::write(const RegisterID& reg, Data data)
     return;
   }
 
-  auto itr = registers.find(reg);
-  if (itr == registers.end())
+  registers[indexOf(reg)] = data;
+}
+
+void RegisterFile::reset()
+{
+  for (auto& data : registers)
+  {
+    data.uw = 0;
+  }
+}
+
+std::size_t RegisterFile::indexOf(const RegisterID& reg) const
+{
+  if (reg.type == RegisterType::GPR && reg.index < numGPR)
+  {
+    return reg.index;
+  }
+  if (reg.type == RegisterType::FPR && reg.index < numFPR)
   {
-    throw InvalidRegisterException(reg);
+    return numGPR + reg.index;
   }
 
-  itr->second = data;
+  throw InvalidRegisterException(reg);
 }
@@ -3,15 +3,21 @@
 
 #include "types.h"
 #include "RegisterID.h"
-#include <unordered_map>
+#include <vector>
 
 class RegisterFile;
 using RegisterFilePtr = Pointer<RegisterFile>;
 
+/**
+ * Stores the GPRs followed by the FPRs in a flat array indexed by register 
+ * number.
+ */
 class RegisterFile
 {
 private:
-  std::unordered_map<RegisterID, Data, RegisterIDHash> registers;
+  const std::size_t numGPR;
+  const std::size_t numFPR;
+  std::vector<Data> registers;
 
 public:
   RegisterFile() = delete;
@@ -19,6 +25,17 @@ public:
 
   Data read(const RegisterID& reg) const;
   void write(const RegisterID& reg, Data data);
+
+  /**
+   * Sets every register to zero.
+   */
+  void reset();
+
+private:
+  /**
+   * Returns the array index of reg, or throws if it doesn't exist.
+   */
+  std::size_t indexOf(const RegisterID& reg) const;
 };
 
 #endif
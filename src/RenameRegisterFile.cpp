@@ -1,41 +1,61 @@
 #include "RenameRegisterFile.h"
+#include "Exceptions.h"
 #include "log.h"
 #include <string>
 #include <iostream>
+#include <algorithm>
 
 static const std::string TAG = "RenameRegisterFile";
 
-RenameRegisterFile::RenameRegisterFile()
-  : renameRegisters()
+RenameRegisterFile::RenameRegisterFile(std::size_t numGPR, std::size_t numFPR)
+  : numGPR(numGPR),
+    numFPR(numFPR),
+    renameRegisters(numGPR + numFPR, ReservationStationID::NONE),
+    reverseRenames()
 {
 }
 
 void RenameRegisterFile::rename(const RegisterID& reg, 
   const ReservationStationID& rsid)
 {
-  auto itr = renameRegisters.find(reg);
-  if (itr != renameRegisters.end())
+  auto idx = indexOf(reg);
+  if (idx == renameRegisters.size())
+  {
+    throw InvalidRegisterException(reg);
+  }
+
+  auto& current = renameRegisters[idx];
+  if (current != ReservationStationID::NONE)
   {
     logger->warning(TAG) << "Overwriting rename of "
-      << reg << " -> " << itr->second << " to "
+      << reg << " -> " << current << " to "
       << reg << " -> " << rsid;
+    reverseEntry(current) = RegisterID::NONE;
   }
   else
   {
     logger->debug(TAG) << "Renaming " << reg << " -> " << rsid;
   }
 
-  renameRegisters[reg] = rsid;  
+  current = rsid;
+  reverseEntry(rsid) = reg;
 }
 
 void RenameRegisterFile::clearRename(const RegisterID& reg)
 {
-  auto itr = renameRegisters.find(reg);
-  if (itr != renameRegisters.end())
+  auto idx = indexOf(reg);
+  if (idx == renameRegisters.size())
+  {
+    return;
+  }
+
+  auto& current = renameRegisters[idx];
+  if (current != ReservationStationID::NONE)
   {
     logger->debug(TAG) << "Clearing renaming of " << reg 
-      << " (was " << itr->second << ")";
-    renameRegisters.erase(itr);
+      << " (was " << current << ")";
+    reverseEntry(current) = RegisterID::NONE;
+    current = ReservationStationID::NONE;
   }
 }
 
@@ -44,24 +64,72 @@ void RenameRegisterFile::clearRename(const ReservationStationID& rsid)
   clearRename(getReverseRename(rsid));
 }
 
+void RenameRegisterFile::reset()
+{
+  std::fill(renameRegisters.begin(), renameRegisters.end(), 
+    ReservationStationID::NONE);
+  for (auto& reverse : reverseRenames)
+  {
+    std::fill(reverse.begin(), reverse.end(), RegisterID::NONE);
+  }
+}
+
 ReservationStationID RenameRegisterFile::getRenaming(
   const RegisterID& reg) const
 {
-  auto itr = renameRegisters.find(reg);
-  return itr == renameRegisters.end() ?
-    ReservationStationID::NONE : itr->second;
+  auto idx = indexOf(reg);
+  return idx == renameRegisters.size() ?
+    ReservationStationID::NONE : renameRegisters[idx];
 }
 
 RegisterID RenameRegisterFile::getReverseRename(
   const ReservationStationID& rsid) const
 {
-  for (auto entry : renameRegisters)
+  auto type = static_cast<std::size_t>(rsid.type);
+  if (type >= reverseRenames.size() || rsid.index >= reverseRenames[type].size())
+  {
+    return RegisterID::NONE;
+  }
+
+  return reverseRenames[type][rsid.index];
+}
+
+void RenameRegisterFile::writeSignature(std::vector<uint64_t>& out) const
+{
+  for (const auto& rsid : renameRegisters)
+  {
+    out.push_back(static_cast<uint64_t>(rsid.type));
+    out.push_back(rsid.index);
+  }
+}
+
+std::size_t RenameRegisterFile::indexOf(const RegisterID& reg) const
+{
+  if (reg.type == RegisterType::GPR && reg.index < numGPR)
+  {
+    return reg.index;
+  }
+  if (reg.type == RegisterType::FPR && reg.index < numFPR)
+  {
+    return numGPR + reg.index;
+  }
+
+  return renameRegisters.size();
+}
+
+RegisterID& RenameRegisterFile::reverseEntry(const ReservationStationID& rsid)
+{
+  // the table grows the first time each station renames a register, after 
+  // that the lookups are direct
+  auto type = static_cast<std::size_t>(rsid.type);
+  if (type >= reverseRenames.size())
+  {
+    reverseRenames.resize(type + 1);
+  }
+  if (rsid.index >= reverseRenames[type].size())
   {
-    if (entry.second == rsid)
-    {
-      return entry.first;
-    }
+    reverseRenames[type].resize(rsid.index + 1, RegisterID::NONE);
   }
 
-  return RegisterID::NONE;
+  return reverseRenames[type][rsid.index];
 }
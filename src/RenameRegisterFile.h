@@ -4,26 +4,52 @@
 #include "types.h"
 #include "RegisterID.h"
 #include "ReservationStationID.h"
-#include <unordered_map>
+#include <vector>
 
 class RenameRegisterFile;
 using RenameRegisterFilePtr = Pointer<RenameRegisterFile>;
 
+/**
+ * Maps registers to the reservation stations that will produce their values.  
+ * Both directions are stored in flat arrays: register -> station uses the 
+ * same layout as RegisterFile, and station -> register is indexed by station 
+ * type then index.
+ */
 class RenameRegisterFile
 {
 private:
-  std::unordered_map<RegisterID, ReservationStationID, RegisterIDHash> 
-    renameRegisters;
+  const std::size_t numGPR;
+  const std::size_t numFPR;
+  std::vector<ReservationStationID> renameRegisters;
+  std::vector<std::vector<RegisterID>> reverseRenames;
 
 public:
-  RenameRegisterFile();
+  RenameRegisterFile() = delete;
+  RenameRegisterFile(std::size_t numGPR, std::size_t numFPR);
 
   void rename(const RegisterID& reg, const ReservationStationID& rsid);
   void clearRename(const RegisterID& reg);
   void clearRename(const ReservationStationID& rsid);
 
+  /**
+   * Clears every renaming.
+   */
+  void reset();
+
   ReservationStationID getRenaming(const RegisterID& reg) const;
   RegisterID getReverseRename(const ReservationStationID& rsid) const;
+
+  /**
+   * Appends the station every register is renamed to.
+   */
+  void writeSignature(std::vector<uint64_t>& out) const;
+
+private:
+  /**
+   * Returns the array index of reg, or the array size if it doesn't exist.
+   */
+  std::size_t indexOf(const RegisterID& reg) const;
+  RegisterID& reverseEntry(const ReservationStationID& rsid);
 };
 
 #endif
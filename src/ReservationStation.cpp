@@ -14,33 +14,51 @@ ReservationStationDependencies::ReservationStationDependencies(
   MemoryPtr memory, 
   Address& pc,
   bool& pcStall,
-  CommonDataBusPtr cdb)
+  const std::size_t& clock,
+  CommonDataBusPtr cdb,
+  PerformanceCountersPtr counters)
   : registers(registers),
     renameRegisters(renameRegisters),
     memory(memory),
     pc(pc),
     pcStall(pcStall),
-    cdb(cdb)
+    clock(clock),
+    cdb(cdb),
+    counters(counters),
+    trace(nullptr),
+    dataflow(nullptr),
+    coSimulation(nullptr),
+    events(nullptr),
+    fastForward(nullptr),
+    replay(false)
 {
 }
 
 ReservationStation::ReservationStation(const ReservationStationID& id,
-  const std::size_t executeCycles, ReservationStationDependencies& deps)
+  const std::size_t executeCycles, ReservationStationDependencies& deps,
+  StationTable& table, PerformanceCounters::Counter* waitingCycles)
   : id(id),
     deps(deps),
     instruction(nullptr),
-    state(ReservationStationState::Idle),
     executeCycles(executeCycles),
     startClock(0),
     executeCyclesRemaining(0),
-    arg1(),
-    arg1Ready(false),
-    arg1Source(ReservationStationID::NONE),
-    arg2(),
-    arg2Ready(false),
-    arg2Source(ReservationStationID::NONE),
-    result()
+    result(),
+    traceSequence(PipelineTrace::NO_SEQUENCE),
+    waitingCycles(waitingCycles),
+    state(table.states[id.index]),
+    arg1(table.arg1[id.index]),
+    arg1Ready(table.arg1Ready[id.index]),
+    arg1Source(table.arg1Sources[id.index]),
+    arg2(table.arg2[id.index]),
+    arg2Ready(table.arg2Ready[id.index]),
+    arg2Source(table.arg2Sources[id.index]),
+    dumpedState(ReservationStationState::Idle),
+    dumpedStartClock(0),
+    dumpedArg1Ready(false),
+    dumpedArg2Ready(false)
 {
+  state = ReservationStationState::Idle;
 }
 
 ReservationStationID ReservationStation::getID() const
@@ -63,6 +81,11 @@ RegisterID ReservationStation::getDest() const
   return instruction->getDest();
 }
 
+Address ReservationStation::getAddress() const
+{
+  return instruction->getAddress();
+}
+
 Data ReservationStation::getResult() const
 {
   return result;
@@ -75,6 +98,10 @@ void ReservationStation::setInstruction(InstructionPtr instr, std::size_t clock)
 
   startClock = clock;
   executeCyclesRemaining = executeCycles;
+  if (deps.trace)
+  {
+    traceSequence = deps.trace->begin(id, instruction->getAddress(), clock);
+  }
   arg1.uw = 0;
   arg1Ready = false;
   arg1Source = ReservationStationID::NONE;
@@ -84,6 +111,23 @@ void ReservationStation::setInstruction(InstructionPtr instr, std::size_t clock)
   result.uw = 0;
 
   setArgSources();
+  if (deps.dataflow)
+  {
+    deps.dataflow->issue(id, *instruction, executeCycles, arg1Source, 
+      arg2Source);
+  }
+  if (deps.coSimulation)
+  {
+    deps.coSimulation->issue(id, instruction);
+  }
+  if (deps.events && deps.events->issue)
+  {
+    deps.events->issue(id, *instruction, clock);
+  }
+  if (deps.fastForward)
+  {
+    deps.fastForward->issue(id, *instruction);
+  }
   if (arg1Ready && arg2Ready)
   {
     state = ReservationStationState::ReadyToExecute;
@@ -91,7 +135,14 @@ void ReservationStation::setInstruction(InstructionPtr instr, std::size_t clock)
   }
   else
   {
-    deps.cdb->addListener(this);
+    if (!arg1Ready)
+    {
+      deps.cdb->addListener(this, arg1Source);
+    }
+    if (!arg2Ready && (arg1Ready || arg2Source != arg1Source))
+    {
+      deps.cdb->addListener(this, arg2Source);
+    }
     state = ReservationStationState::WaitingForArgs;
   }
 
@@ -104,15 +155,41 @@ void ReservationStation::setInstruction(InstructionPtr instr, std::size_t clock)
 
 void ReservationStation::clearInstruction()
 {
+  trace(PipelineEvent::Retire);
+  if (deps.events && deps.events->retire)
+  {
+    deps.events->retire(id, *instruction);
+  }
   deps.renameRegisters->clearRename(id);
   instruction = InstructionPtr();
   state = ReservationStationState::Idle;
   logger->debug(TAG) << id << " cleared";
 }
 
+void ReservationStation::reset()
+{
+  instruction = InstructionPtr();
+  startClock = 0;
+  executeCyclesRemaining = 0;
+  result.uw = 0;
+  traceSequence = PipelineTrace::NO_SEQUENCE;
+  state = ReservationStationState::Idle;
+  arg1.uw = 0;
+  arg1Ready = false;
+  arg1Source = ReservationStationID::NONE;
+  arg2.uw = 0;
+  arg2Ready = false;
+  arg2Source = ReservationStationID::NONE;
+  dumpedState = ReservationStationState::Idle;
+  dumpedStartClock = 0;
+  dumpedArg1Ready = false;
+  dumpedArg2Ready = false;
+}
+
 void ReservationStation::setIsExecuting()
 {
   state = ReservationStationState::Executing;
+  trace(PipelineEvent::ExecuteStart);
   logger->debug(TAG) << id << " moved to execute stage";
 }
 
@@ -121,8 +198,17 @@ void ReservationStation::execute()
   executeCyclesRemaining--;
   if (executeCyclesRemaining == 0)
   {
-    result = instruction->execute(arg1, arg2);
+    if (!deps.replay)
+    {
+      result = instruction->execute(arg1, arg2);
+    }
+    if (instruction->getType() == FunctionalUnitType::Memory 
+      && instruction->getWriteAction() == WriteAction::Register)
+    {
+      deps.counters->loads++;
+    }
     state = ReservationStationState::ExecutionComplete;
+    trace(PipelineEvent::ExecuteComplete);
     logger->debug(TAG) << id << " completed execution";
   }
   else
@@ -135,6 +221,7 @@ void ReservationStation::execute()
 void ReservationStation::setIsWriting()
 {
   state = ReservationStationState::Writing;
+  trace(PipelineEvent::WriteRequest);
   logger->debug(TAG) << id << " moved to write stage";
 }
 
@@ -171,54 +258,68 @@ void ReservationStation::write()
     break;
 
   case WriteAction::Memory:
-    deps.memory->writeUWord(result.uw, arg2.uw);
+    if (deps.coSimulation)
+    {
+      deps.coSimulation->store(id, result.uw, arg2.uw);
+    }
+    if (!deps.replay)
+    {
+      deps.memory->writeUWord(result.uw, arg2.uw);
+    }
+    deps.counters->stores++;
     state = ReservationStationState::WriteComplete;
     logger->debug(TAG) << id << " wrote value " << util::hex<UWord> << arg2.uw
       << " to address " << util::hex<UWord> << result.uw;
     break;
   }
+
+  // writes that do not use the CDB are granted immediately
+  if (state == ReservationStationState::WriteComplete)
+  {
+    trace(PipelineEvent::WriteGrant);
+  }
 }
 
-void ReservationStation::dumpState() const
+void ReservationStation::dumpState(std::ostream& os) const
 {
   switch (state)
   {
   case ReservationStationState::Idle:
-    //std::cout << "\t" << id << ": idle" << std::endl;
+    //os << "\t" << id << ": idle" << std::endl;
     break;
 
   case ReservationStationState::WaitingForArgs:
-    std::cout << "\t" << id << ": " << instruction->getName() 
+    os << "\t" << id << ": " << instruction->getName() 
       << ", waiting for ";
     if (!arg1Ready)
     {
-      std::cout << arg1Source;
+      os << arg1Source;
     }
     if (!arg1Ready && !arg2Ready)
     {
-      std::cout << " and ";
+      os << " and ";
     }
     if (!arg2Ready)
     {
-      std::cout << arg2Source;
+      os << arg2Source;
     }
-    std::cout << std::endl;
+    os << std::endl;
     break;
 
   case ReservationStationState::ReadyToExecute:  
-    std::cout << "\t" << id << ": " << instruction->getName()
+    os << "\t" << id << ": " << instruction->getName()
       << ", ready to execute" << std::endl;
     break;
 
   case ReservationStationState::Executing:
   case ReservationStationState::ExecutionComplete:
-    std::cout << "\t" << id << ": " << instruction->getName()
+    os << "\t" << id << ": " << instruction->getName()
       << ", executing" << std::endl;
     break;
 
   case ReservationStationState::Writing:
   case ReservationStationState::WriteComplete:
-    std::cout << "\t" << id << ": " << instruction->getName()
+    os << "\t" << id << ": " << instruction->getName()
       << ", writing" << std::endl;
     break;
       
@@ -227,6 +328,91 @@ void ReservationStation::dumpState() const
   }
 }
 
+void ReservationStation::writeSignature(std::size_t clock, 
+  std::vector<uint64_t>& out) const
+{
+  out.push_back(static_cast<uint64_t>(state));
+  if (state == ReservationStationState::Idle)
+  {
+    return;
+  }
+
+  out.push_back(instruction->getAddress());
+  out.push_back(clock - startClock);
+  out.push_back(executeCyclesRemaining);
+  out.push_back(arg1Ready);
+  out.push_back(static_cast<uint64_t>(arg1Source.type));
+  out.push_back(arg1Source.index);
+  out.push_back(arg2Ready);
+  out.push_back(static_cast<uint64_t>(arg2Source.type));
+  out.push_back(arg2Source.index);
+}
+
+void ReservationStation::fastForward(std::size_t cycles, Data newArg1,
+  Data newArg2, Data newResult)
+{
+  assert(state != ReservationStationState::Idle);
+
+  startClock += cycles;
+  if (arg1Ready)
+  {
+    arg1 = newArg1;
+  }
+  if (arg2Ready)
+  {
+    arg2 = newArg2;
+  }
+
+  bool executed = state == ReservationStationState::ExecutionComplete
+    || state == ReservationStationState::Writing
+    || state == ReservationStationState::WriteComplete;
+  // a writing link instruction already holds its return address, which is 
+  // the same in every instance
+  bool linked = instruction->getWriteAction() == WriteAction::PC_R31
+    && state != ReservationStationState::ExecutionComplete;
+  if (executed && !linked)
+  {
+    result = newResult;
+  }
+}
+
+void ReservationStation::dumpChanges(bool full)
+{
+  // the dump doesn't distinguish between these pairs of states
+  auto shownState = state;
+  if (shownState == ReservationStationState::ExecutionComplete)
+  {
+    shownState = ReservationStationState::Executing;
+  }
+  else if (shownState == ReservationStationState::WriteComplete)
+  {
+    shownState = ReservationStationState::Writing;
+  }
+
+  bool changed = shownState != dumpedState || startClock != dumpedStartClock
+    || arg1Ready != dumpedArg1Ready || arg2Ready != dumpedArg2Ready;
+  if (full)
+  {
+    dumpState();
+  }
+  else if (changed)
+  {
+    if (state == ReservationStationState::Idle)
+    {
+      std::cout << "\t" << id << ": idle" << std::endl;
+    }
+    else
+    {
+      dumpState();
+    }
+  }
+
+  dumpedState = shownState;
+  dumpedStartClock = startClock;
+  dumpedArg1Ready = arg1Ready;
+  dumpedArg2Ready = arg2Ready;
+}
+
 bool ReservationStation::notifyDataBus(const ReservationStationID& rsid,
   Data value)
 {
@@ -251,16 +437,33 @@ bool ReservationStation::notifyDataBus(const ReservationStationID& rsid,
   {
     state = ReservationStationState::ReadyToExecute;
     logger->debug(TAG) << id << " has read all arguments";
+    countOperandWait();
     return true;
   }
 
   return false;
 }
 
+void ReservationStation::countOperandWait()
+{
+  // waiting from the cycle of issue through the one before this
+  auto cycles = deps.clock - startClock;
+  if (waitingCycles)
+  {
+    *waitingCycles += cycles;
+  }
+  if (deps.counters->pcProfile)
+  {
+    deps.counters->pcProfile->at(instruction->getAddress())
+      .operandWaitCycles += cycles;
+  }
+}
+
 void ReservationStation::notifyWriteAccepted()
 {
   assert(state == ReservationStationState::Writing);
   state = ReservationStationState::WriteComplete;
+  trace(PipelineEvent::WriteGrant);
 
   if (instruction->getType() == FunctionalUnitType::Branch)
   {
@@ -321,3 +524,11 @@ void ReservationStation::setArgSources()
     }
   }
 }
+
+void ReservationStation::trace(PipelineEvent event)
+{
+  if (deps.trace)
+  {
+    deps.trace->mark(traceSequence, event);
+  }
+}
@@ -8,17 +8,15 @@
 #include "instructions/Instruction.h"
 #include "Memory.h"
 #include "CommonDataBus.h"
-
-enum class ReservationStationState
-{
-  Idle,
-  WaitingForArgs,
-  ReadyToExecute,
-  Executing,
-  ExecutionComplete,
-  Writing,
-  WriteComplete
-};
+#include "PerformanceCounters.h"
+#include "StationTable.h"
+#include "PipelineTrace.h"
+#include "Dataflow.h"
+#include "CoSimulation.h"
+#include "SimulationEvents.h"
+#include "FastForward.h"
+#include <vector>
+#include <iostream>
 
 struct ReservationStationDependencies
 {
@@ -27,7 +25,9 @@ struct ReservationStationDependencies
     MemoryPtr memory,
     Address& pc,
     bool& pcStall,
-    CommonDataBusPtr cdb
+    const std::size_t& clock,
+    CommonDataBusPtr cdb,
+    PerformanceCountersPtr counters
     );
   ReservationStationDependencies& operator=(ReservationStationDependencies&) 
     = delete;
@@ -37,52 +37,113 @@ struct ReservationStationDependencies
   MemoryPtr memory;
   Address& pc;
   bool& pcStall;
+  const std::size_t& clock;
   CommonDataBusPtr cdb;
+  PerformanceCountersPtr counters;
+  // lifecycle recording, only when set
+  PipelineTracePtr trace;
+  // dataflow recording, only when set
+  DataflowLogPtr dataflow;
+  // lockstep checking against the functional model, only when set
+  CoSimulationPtr coSimulation;
+  // callbacks of an embedding program, only when set
+  SimulationEventsPtr events;
+  // loop fast-forwarding, only when set
+  FastForwardPtr fastForward;
+  // when replaying a trace, instructions are timed without being executed
+  bool replay;
 };
 
 class ReservationStation
 {
 private:  
   const ReservationStationID id;
-  ReservationStationDependencies deps;
+  // shared by all stations
+  ReservationStationDependencies& deps;
   InstructionPtr instruction;
-  ReservationStationState state;
 
   const std::size_t executeCycles;
   std::size_t startClock;
   std::size_t executeCyclesRemaining;
-  Data arg1;
-  bool arg1Ready;
-  ReservationStationID arg1Source;
-  Data arg2;
-  bool arg2Ready;
-  ReservationStationID arg2Source;
   Data result;
+  // this instruction's PipelineTrace record
+  uint64_t traceSequence;
+  // this station's count of cycles waiting for operands, or nullptr
+  PerformanceCounters::Counter* waitingCycles;
+
+  // this station's row of the functional unit's StationTable
+  ReservationStationState& state;
+  Data& arg1;
+  uint8_t& arg1Ready;
+  ReservationStationID& arg1Source;
+  Data& arg2;
+  uint8_t& arg2Ready;
+  ReservationStationID& arg2Source;
+
+  // last state printed by dumpChanges()
+  ReservationStationState dumpedState;
+  std::size_t dumpedStartClock;
+  bool dumpedArg1Ready;
+  bool dumpedArg2Ready;
 
 public:
   ReservationStation() = delete;
+  /**
+   * deps must outlive the station.  The station keeps its state, arguments 
+   * and argument sources in row id.index of table, and adds the cycles each 
+   * instruction waits for its operands to waitingCycles unless it is nullptr.
+   */
   ReservationStation(const ReservationStationID& id, 
-    const std::size_t executeCycles, ReservationStationDependencies& deps);
+    const std::size_t executeCycles, ReservationStationDependencies& deps,
+    StationTable& table, PerformanceCounters::Counter* waitingCycles);
   ReservationStation& operator=(ReservationStation&) = delete;
 
   ReservationStationID getID() const;
   ReservationStationState getState() const;
   std::size_t getStartClock() const;
   RegisterID getDest() const;
+  Address getAddress() const;
   Data getResult() const;
 
   void setInstruction(InstructionPtr instr, std::size_t clock);
   void clearInstruction();
 
+  /**
+   * Drops any instruction without retiring it, leaving the station idle.
+   */
+  void reset();
+
   void setIsExecuting();
   void execute();
   void setIsWriting();
   void write();
-  void dumpState() const;
+  void dumpState(std::ostream& os = std::cout) const;
+
+  /**
+   * Appends everything that decides this station's timing from clock on: its 
+   * state, instruction address, age, remaining execute cycles and operand 
+   * sources, but none of the values it holds.
+   */
+  void writeSignature(std::size_t clock, std::vector<uint64_t>& out) const;
+
+  /**
+   * Turns the instruction into its instance cycles later, which holds the 
+   * operands and result given.  Only values the station already has are 
+   * replaced.
+   */
+  void fastForward(std::size_t cycles, Data newArg1, Data newArg2, 
+    Data newResult);
+
+  /**
+   * Prints the station state if it changed since the last call, or 
+   * unconditionally when full is set.  Unlike dumpState(), a station that 
+   * became idle is reported.
+   */
+  void dumpChanges(bool full);
 
   /**
    * Notify the reservation station of a value written to the CDB.
-   * Returns false if the RS wants to be removed as a CDB listener.
+   * Returns true if the RS now has all of its arguments.
    */
   bool notifyDataBus(const ReservationStationID& rsid, Data value);
 
@@ -94,6 +155,12 @@ public:
 
 private:
   void setArgSources();
+  /**
+   * Charges the cycles since issue to the station and the instruction's 
+   * address, once the last operand has arrived.
+   */
+  void countOperandWait();
+  void trace(PipelineEvent event);
 };
 
 #endif
@@ -0,0 +1,423 @@
+#include "ResultCache.h"
+#include "MachineConfig.h"
+#include "log.h"
+#include "platform.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cerrno>
+#include <ctime>
+
+#if LU_COMPILER == LU_COMPILER_MSVC
+#include <direct.h>
+#include <sys/stat.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utime.h>
+#endif
+
+static const std::string TAG = "ResultCache";
+
+static const std::string MAGIC = "TMRESULT2";
+static const std::string EXTENSION = ".result";
+static const std::string TEMP_PREFIX = ".tmp-";
+static const std::string ESTIMATE_NAME = "size";
+// eviction leaves the results at this share of the limit, so the next one 
+// waits until a tenth of the limit has been stored
+static const uint64_t LOW_WATER_PERCENT = 90;
+// a temporary file older than this was left by a writer that crashed
+static const time_t STALE_SECONDS = 60 * 60;
+
+/**
+ * A 128 bit FNV-1a style hash, made of two differently seeded 64 bit hashes.
+ * It only has to tell inputs apart, it does not need to resist attacks.
+ */
+class Hasher
+{
+private:
+  uint64_t low;
+  uint64_t high;
+
+public:
+  Hasher()
+    : low(0xcbf29ce484222325ull),
+      high(0x84222325cbf29ce4ull)
+  {
+  }
+
+  void add(const void* data, std::size_t size)
+  {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++)
+    {
+      low = (low ^ bytes[i]) * 0x100000001b3ull;
+      high = (high ^ bytes[i]) * 0x100000001b3ull;
+      high ^= high >> 29;
+    }
+  }
+
+  void add(const std::string& s)
+  {
+    uint64_t size = s.size();
+    add(&size, sizeof(size));
+    add(s.data(), s.size());
+  }
+
+  std::string hex() const
+  {
+    std::ostringstream os;
+    os << std::hex << std::setfill('0') << std::setw(16) << high
+      << std::setw(16) << low;
+    return os.str();
+  }
+};
+
+/**
+ * Reads a length prefixed section named name.
+ */
+static bool readSection(std::istream& is, const std::string& name,
+  std::string& out)
+{
+  std::string tag;
+  std::size_t size = 0;
+  if (!(is >> tag >> size) || tag != name || is.get() != '\n')
+  {
+    return false;
+  }
+  out.resize(size);
+  return size == 0 || static_cast<bool>(is.read(&out[0], size));
+}
+
+static void writeSection(std::ostream& os, const std::string& name,
+  const std::string& data)
+{
+  os << name << " " << data.size() << "\n";
+  os.write(data.data(), data.size());
+}
+
+/**
+ * Moves the finished file temp over path, or removes it if that fails.
+ */
+static bool replaceFile(const std::string& temp, const std::string& path)
+{
+#if LU_COMPILER == LU_COMPILER_MSVC
+  // rename does not replace files on windows
+  std::remove(path.c_str());
+#endif
+  if (std::rename(temp.c_str(), path.c_str()) != 0)
+  {
+    std::remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+ResultCache::ResultCache(const std::string& directory, uint64_t maxBytes,
+  const std::string& version)
+  : directory(directory),
+    maxBytes(maxBytes),
+    version(version)
+{
+}
+
+bool ResultCache::open()
+{
+#if LU_COMPILER == LU_COMPILER_MSVC
+  if (_mkdir(directory.c_str()) != 0 && errno != EEXIST)
+#else
+  if (mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST)
+#endif
+  {
+    logger->error(TAG) << "Unable to create " << directory;
+    return false;
+  }
+  return true;
+}
+
+std::string ResultCache::key(const Memory& image) const
+{
+  Hasher hasher;
+  hasher.add(MAGIC);
+  hasher.add(version);
+  uint64_t size = image.size();
+  hasher.add(&size, sizeof(size));
+  auto bytes = image.snapshot();
+  hasher.add(bytes.data(), bytes.size());
+  return hasher.hex();
+}
+
+bool ResultCache::find(const std::string& key, CachedResult& out) const
+{
+  auto path = pathOf(key);
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+
+  std::string magic;
+  std::string tag;
+  if (!std::getline(file, magic) || magic != MAGIC
+    || !(file >> tag >> out.cycles) || tag != "cycles"
+    || !(file >> tag >> out.idleCycles) || tag != "idle"
+    || !(file >> tag >> out.stateDigest) || tag != "digest"
+    || file.get() != '\n'
+    || !readSection(file, "output", out.output)
+    || !readSection(file, "stats", out.statsText)
+    || !readSection(file, "json", out.statsJson))
+  {
+    logger->warning(TAG) << "Ignoring damaged result " << path;
+    return false;
+  }
+
+  // a result that is used is kept longest by evict()
+  utime(path.c_str(), nullptr);
+  logger->info(TAG) << "Reusing result " << key;
+  return true;
+}
+
+bool ResultCache::store(const std::string& key,
+  const CachedResult& result) const
+{
+  // other processes may store the same key at the same time, so each writes
+  // its own file and renames it into place whole
+  auto temp = tempPath();
+  uint64_t written = 0;
+  {
+    std::ofstream file(temp.c_str(), std::ios::out | std::ios::binary);
+    file << MAGIC << "\n"
+      << "cycles " << result.cycles << "\n"
+      << "idle " << result.idleCycles << "\n"
+      << "digest " << result.stateDigest << "\n";
+    writeSection(file, "output", result.output);
+    writeSection(file, "stats", result.statsText);
+    writeSection(file, "json", result.statsJson);
+    if (!file.flush())
+    {
+      file.close();
+      std::remove(temp.c_str());
+      logger->warning(TAG) << "Unable to write " << temp;
+      return false;
+    }
+    written = static_cast<uint64_t>(file.tellp());
+  }
+
+  auto path = pathOf(key);
+  if (!replaceFile(temp, path))
+  {
+    logger->warning(TAG) << "Unable to store " << path;
+    return false;
+  }
+  logger->info(TAG) << "Stored result " << key;
+
+  // listing the directory stats every result, so it is only done when the 
+  // estimate says the limit may be passed.  Stores racing with this one can 
+  // lose their share of the estimate, which only delays the next eviction
+  uint64_t estimate = 0;
+  if (readEstimate(estimate) && estimate + written <= maxBytes)
+  {
+    estimate += written;
+  }
+  else
+  {
+    estimate = evict();
+  }
+  writeEstimate(estimate);
+  return true;
+}
+
+void ResultCache::describe(const Tomasulo& tomasulo,
+  const std::string& output, CachedResult& out)
+{
+  Hasher hasher;
+  for (std::size_t i = 0; i < GPR_REGISTERS + FPR_REGISTERS; i++)
+  {
+    UWord value = tomasulo.getRegisters().read(registerAt(i)).uw;
+    hasher.add(&value, sizeof(value));
+  }
+  auto bytes = tomasulo.getMemory().snapshot();
+  hasher.add(bytes.data(), bytes.size());
+
+  std::ostringstream text;
+  tomasulo.counters().writeText(text);
+  std::ostringstream json;
+  tomasulo.counters().writeJson(json);
+
+  out.cycles = tomasulo.clocks();
+  out.idleCycles = tomasulo.longestIdle();
+  out.stateDigest = hasher.hex();
+  out.output = output;
+  out.statsText = text.str();
+  out.statsJson = json.str();
+}
+
+std::string ResultCache::pathOf(const std::string& key) const
+{
+  return directory + "/" + key + EXTENSION;
+}
+
+std::string ResultCache::tempPath() const
+{
+  std::random_device random;
+  std::ostringstream os;
+  os << directory << "/" << TEMP_PREFIX << std::hex << random() << random();
+  return os.str();
+}
+
+bool ResultCache::readEstimate(uint64_t& bytes) const
+{
+  auto path = directory + "/" + ESTIMATE_NAME;
+  std::ifstream file(path.c_str(), std::ios::in);
+  return static_cast<bool>(file >> bytes);
+}
+
+void ResultCache::writeEstimate(uint64_t bytes) const
+{
+  auto temp = tempPath();
+  {
+    std::ofstream file(temp.c_str(), std::ios::out);
+    file << bytes << "\n";
+    if (!file.flush())
+    {
+      file.close();
+      std::remove(temp.c_str());
+      return;
+    }
+  }
+  // without an estimate the next store lists the directory again
+  replaceFile(temp, directory + "/" + ESTIMATE_NAME);
+}
+
+#if LU_COMPILER == LU_COMPILER_MSVC
+
+uint64_t ResultCache::evict() const
+{
+  // listing directories is not supported here, so the cache is unbounded
+  return 0;
+}
+
+#else
+
+uint64_t ResultCache::evict() const
+{
+  struct Entry
+  {
+    std::string path;
+    uint64_t size;
+    time_t used;
+  };
+
+  DIR* dir = opendir(directory.c_str());
+  if (!dir)
+  {
+    return 0;
+  }
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+  auto now = time(nullptr);
+  while (struct dirent* entry = readdir(dir))
+  {
+    std::string name = entry->d_name;
+    struct stat info;
+    auto path = directory + "/" + name;
+    if (name.size() > EXTENSION.size()
+      && name.compare(name.size() - EXTENSION.size(), EXTENSION.size(),
+        EXTENSION) == 0
+      && stat(path.c_str(), &info) == 0)
+    {
+      entries.push_back(Entry{ path, static_cast<uint64_t>(info.st_size),
+        info.st_mtime });
+      total += info.st_size;
+    }
+    else if (name.compare(0, TEMP_PREFIX.size(), TEMP_PREFIX) == 0
+      && stat(path.c_str(), &info) == 0
+      && now - info.st_mtime > STALE_SECONDS)
+    {
+      std::remove(path.c_str());
+      logger->info(TAG) << "Removed abandoned " << path;
+    }
+  }
+  closedir(dir);
+
+  if (total <= maxBytes)
+  {
+    return total;
+  }
+  auto lowWater = maxBytes / 100 * LOW_WATER_PERCENT;
+  std::sort(entries.begin(), entries.end(),
+    [](const Entry& a, const Entry& b) { return a.used < b.used; });
+  for (const auto& entry : entries)
+  {
+    if (total <= lowWater)
+    {
+      break;
+    }
+    // another process may have removed it already
+    std::remove(entry.path.c_str());
+    total -= entry.size;
+    logger->info(TAG) << "Evicted " << entry.path;
+  }
+  return total;
+}
+
+#endif
+
+std::string simulatorVersion()
+{
+  Hasher hasher;
+  std::ifstream exe("/proc/self/exe", std::ios::in | std::ios::binary);
+  if (exe)
+  {
+    char buffer[65536];
+    while (exe.read(buffer, sizeof(buffer)) || exe.gcount() > 0)
+    {
+      hasher.add(buffer, static_cast<std::size_t>(exe.gcount()));
+    }
+  }
+  else
+  {
+    hasher.add(std::string(__DATE__ " " __TIME__));
+  }
+  return hasher.hex();
+}
+
+RecordingBuffer::RecordingBuffer(std::ostream& os)
+  : os(os),
+    recorded()
+{
+}
+
+const std::string& RecordingBuffer::str() const
+{
+  return recorded;
+}
+
+RecordingBuffer::int_type RecordingBuffer::overflow(int_type ch)
+{
+  if (!traits_type::eq_int_type(ch, traits_type::eof()))
+  {
+    recorded.push_back(traits_type::to_char_type(ch));
+    os.put(traits_type::to_char_type(ch));
+  }
+  return traits_type::not_eof(ch);
+}
+
+std::streamsize RecordingBuffer::xsputn(const char* s, std::streamsize n)
+{
+  recorded.append(s, static_cast<std::size_t>(n));
+  os.write(s, n);
+  return n;
+}
+
+int RecordingBuffer::sync()
+{
+  os.flush();
+  return 0;
+}
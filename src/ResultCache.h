@@ -0,0 +1,127 @@
+#ifndef __RESULTCACHE_H__
+#define __RESULTCACHE_H__
+
+#include "types.h"
+#include "Memory.h"
+#include "Tomasulo.h"
+#include <streambuf>
+#include <ostream>
+#include <string>
+
+class ResultCache;
+using ResultCachePtr = Pointer<ResultCache>;
+
+/**
+ * What a finished run produced.
+ */
+struct CachedResult
+{
+  uint64_t cycles;
+  // the most cycles without progress, as Tomasulo::longestIdle()
+  uint64_t idleCycles;
+  // a hash of the registers and memory after the run
+  std::string stateDigest;
+  std::string output;
+  std::string statsText;
+  std::string statsJson;
+};
+
+/**
+ * Stores the results of runs in a directory, one file per result, named by a
+ * hash of the program image and the simulator version.  Results are written
+ * to a temporary file and renamed into place, so any number of processes
+ * can share the directory.  When the files grow past the size limit, the
+ * least recently used results are removed.  The processes share an estimate
+ * of the size, so the directory is only listed when it may be too big.
+ */
+class ResultCache
+{
+private:
+  const std::string directory;
+  const uint64_t maxBytes;
+  const std::string version;
+
+public:
+  /**
+   * version identifies the simulator, so results of other builds are not
+   * reused.
+   */
+  ResultCache(const std::string& directory, uint64_t maxBytes,
+    const std::string& version);
+  ResultCache(const ResultCache&) = delete;
+  ResultCache& operator=(const ResultCache&) = delete;
+
+  /**
+   * Creates the directory if needed.  Returns false if it cannot be used.
+   */
+  bool open();
+
+  /**
+   * The key of running the program in image.
+   */
+  std::string key(const Memory& image) const;
+
+  /**
+   * Reads the result stored for key.  Returns false if there is none.
+   */
+  bool find(const std::string& key, CachedResult& out) const;
+
+  /**
+   * Stores the result for key, then evicts results if the size estimate
+   * passes the limit.
+   */
+  bool store(const std::string& key, const CachedResult& result) const;
+
+  /**
+   * Fills out from a finished run.
+   */
+  static void describe(const Tomasulo& tomasulo, const std::string& output,
+    CachedResult& out);
+
+private:
+  std::string pathOf(const std::string& key) const;
+  std::string tempPath() const;
+
+  /**
+   * Reads the estimated size of the results.  Returns false if there is no
+   * estimate.
+   */
+  bool readEstimate(uint64_t& bytes) const;
+  void writeEstimate(uint64_t bytes) const;
+
+  /**
+   * Removes the least recently used results until they fit well under the
+   * limit, and files left by writers that crashed.  Returns the size of the
+   * remaining results.
+   */
+  uint64_t evict() const;
+};
+
+/**
+ * Identifies this build of the simulator by hashing its executable, or by
+ * its build time when the executable cannot be read.
+ */
+extern std::string simulatorVersion();
+
+/**
+ * Passes everything written to it on to another stream, keeping a copy.
+ */
+class RecordingBuffer
+  : public std::streambuf
+{
+private:
+  std::ostream& os;
+  std::string recorded;
+
+public:
+  explicit RecordingBuffer(std::ostream& os);
+
+  const std::string& str() const;
+
+protected:
+  virtual int_type overflow(int_type ch) override;
+  virtual std::streamsize xsputn(const char* s, std::streamsize n) override;
+  virtual int sync() override;
+};
+
+#endif
@@ -0,0 +1,636 @@
+#include "Server.h"
+#include "Memory.h"
+#include "Loader.h"
+#include "Tomasulo.h"
+#include "Exceptions.h"
+#include "log.h"
+#include "platform.h"
+#include <streambuf>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#if LU_COMPILER != LU_COMPILER_MSVC
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static const std::string TAG = "Server";
+
+// programs kept loaded between jobs
+static const std::size_t IMAGE_CACHE_SIZE = 256;
+// the reply tag of failures that do not belong to a job
+static const std::string NO_JOB = "-";
+
+/**
+ * One client of the server.  Commands are only read by the connection's
+ * reader thread, while replies may be sent by any worker.
+ */
+class ServerConnection
+{
+private:
+  const int fd;
+  std::mutex sendMutex;
+  bool failed;
+  // bytes received but not yet consumed
+  std::string received;
+
+public:
+  explicit ServerConnection(int fd);
+  ServerConnection(const ServerConnection&) = delete;
+  ServerConnection& operator=(const ServerConnection&) = delete;
+  ~ServerConnection();
+
+  /**
+   * Reads the next line without its newline.  Returns false at the end of
+   * the input.
+   */
+  bool readLine(std::string& line);
+
+  /**
+   * Reads exactly count bytes.
+   */
+  bool readBytes(std::size_t count, std::string& out);
+
+  /**
+   * Sends header and a newline, followed by size bytes of data, as one
+   * message.  Returns false once the client has gone.
+   */
+  bool send(const std::string& header, const char* data = nullptr,
+    std::size_t size = 0);
+
+private:
+  bool receive();
+};
+
+/**
+ * Sends what a job writes as output messages.
+ */
+class JobOutputBuffer
+  : public std::streambuf
+{
+private:
+  ServerConnection& connection;
+  const std::string& id;
+  char buffer[4096];
+
+public:
+  JobOutputBuffer(ServerConnection& connection, const std::string& id);
+
+protected:
+  virtual int_type overflow(int_type ch) override;
+  virtual int sync() override;
+
+private:
+  void sendBuffer();
+};
+
+/**
+ * Sends a message with text as its data.
+ */
+static void sendMessage(ServerConnection& connection, const std::string& id,
+  const std::string& kind, const std::string& text)
+{
+  std::ostringstream header;
+  header << id << " " << kind << " " << text.size();
+  connection.send(header.str(), text.data(), text.size());
+}
+
+#if LU_COMPILER != LU_COMPILER_MSVC
+
+ServerConnection::ServerConnection(int fd)
+  : fd(fd),
+    sendMutex(),
+    failed(false),
+    received()
+{
+}
+
+ServerConnection::~ServerConnection()
+{
+  close(fd);
+}
+
+bool ServerConnection::readLine(std::string& line)
+{
+  std::size_t end;
+  while ((end = received.find('\n')) == std::string::npos)
+  {
+    if (!receive())
+    {
+      // a last line without a newline still counts
+      line.swap(received);
+      received.clear();
+      return !line.empty();
+    }
+  }
+
+  line = received.substr(0, end);
+  received.erase(0, end + 1);
+  if (!line.empty() && line.back() == '\r')
+  {
+    line.pop_back();
+  }
+  return true;
+}
+
+bool ServerConnection::readBytes(std::size_t count, std::string& out)
+{
+  while (received.size() < count)
+  {
+    if (!receive())
+    {
+      return false;
+    }
+  }
+
+  out = received.substr(0, count);
+  received.erase(0, count);
+  return true;
+}
+
+bool ServerConnection::send(const std::string& header, const char* data,
+  std::size_t size)
+{
+  std::lock_guard<std::mutex> lock(sendMutex);
+
+  std::string message = header + "\n";
+  message.append(data, size);
+  std::size_t sent = 0;
+  while (!failed && sent < message.size())
+  {
+    auto n = ::send(fd, message.data() + sent, message.size() - sent,
+      MSG_NOSIGNAL);
+    if (n < 0 && errno != EINTR)
+    {
+      logger->warning(TAG) << "Client went away: " << std::strerror(errno);
+      failed = true;
+    }
+    else if (n > 0)
+    {
+      sent += static_cast<std::size_t>(n);
+    }
+  }
+  return !failed;
+}
+
+bool ServerConnection::receive()
+{
+  char buffer[4096];
+  ssize_t n;
+  do
+  {
+    n = recv(fd, buffer, sizeof(buffer), 0);
+  } while (n < 0 && errno == EINTR);
+
+  if (n <= 0)
+  {
+    return false;
+  }
+  received.append(buffer, static_cast<std::size_t>(n));
+  return true;
+}
+
+#else
+
+ServerConnection::ServerConnection(int fd)
+  : fd(fd),
+    sendMutex(),
+    failed(true),
+    received()
+{
+}
+
+ServerConnection::~ServerConnection()
+{
+}
+
+bool ServerConnection::readLine(std::string&)
+{
+  return false;
+}
+
+bool ServerConnection::readBytes(std::size_t, std::string&)
+{
+  return false;
+}
+
+bool ServerConnection::send(const std::string&, const char*, std::size_t)
+{
+  return false;
+}
+
+bool ServerConnection::receive()
+{
+  return false;
+}
+
+#endif
+
+JobOutputBuffer::JobOutputBuffer(ServerConnection& connection,
+  const std::string& id)
+  : connection(connection),
+    id(id)
+{
+  setp(buffer, buffer + sizeof(buffer));
+}
+
+JobOutputBuffer::int_type JobOutputBuffer::overflow(int_type ch)
+{
+  sendBuffer();
+  if (!traits_type::eq_int_type(ch, traits_type::eof()))
+  {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+int JobOutputBuffer::sync()
+{
+  sendBuffer();
+  return 0;
+}
+
+void JobOutputBuffer::sendBuffer()
+{
+  auto size = static_cast<std::size_t>(pptr() - pbase());
+  if (size > 0)
+  {
+    std::ostringstream header;
+    header << id << " output " << size;
+    connection.send(header.str(), pbase(), size);
+  }
+  setp(buffer, buffer + sizeof(buffer));
+}
+
+Server::Server(const std::string& socketPath, std::size_t workers,
+  std::size_t memorySize, const JobLimits& limits)
+  : socketPath(socketPath),
+    numWorkers(workers > 0 ? workers : 1),
+    memorySize(memorySize),
+    defaultLimits(limits),
+    listenSocket(-1),
+    jobsMutex(),
+    jobsReady(),
+    jobs(),
+    stopping(false),
+    workers(),
+    imagesMutex(),
+    images(),
+    imageAges()
+{
+}
+
+Server::~Server()
+{
+  {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    stopping = true;
+  }
+  jobsReady.notify_all();
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+
+#if LU_COMPILER != LU_COMPILER_MSVC
+  if (listenSocket >= 0)
+  {
+    close(listenSocket);
+    unlink(socketPath.c_str());
+  }
+#endif
+}
+
+#if LU_COMPILER != LU_COMPILER_MSVC
+
+bool Server::listen()
+{
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path))
+  {
+    logger->error(TAG) << "Socket path is too long: " << socketPath;
+    return false;
+  }
+  std::strcpy(address.sun_path, socketPath.c_str());
+
+  listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenSocket < 0)
+  {
+    logger->error(TAG) << "Unable to create socket: " << std::strerror(errno);
+    return false;
+  }
+  // a socket left behind by an earlier server would make bind fail
+  unlink(socketPath.c_str());
+  if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address),
+      sizeof(address)) < 0
+    || ::listen(listenSocket, SOMAXCONN) < 0)
+  {
+    logger->error(TAG) << "Unable to listen on " << socketPath << ": "
+      << std::strerror(errno);
+    close(listenSocket);
+    listenSocket = -1;
+    return false;
+  }
+
+  for (std::size_t i = 0; i < numWorkers; i++)
+  {
+    workers.emplace_back(&Server::work, this);
+  }
+  logger->info(TAG) << "Listening on " << socketPath << " with "
+    << numWorkers << " workers";
+  return true;
+}
+
+void Server::run()
+{
+  while (listenSocket >= 0)
+  {
+    int fd = accept(listenSocket, nullptr, nullptr);
+    if (fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+      {
+        continue;
+      }
+      logger->error(TAG) << "Unable to accept connections: "
+        << std::strerror(errno);
+      return;
+    }
+
+    logger->info(TAG) << "Accepted a connection";
+    ServerConnectionPtr connection(new ServerConnection(fd));
+    std::thread(&Server::readJobs, this, connection).detach();
+  }
+}
+
+#else
+
+bool Server::listen()
+{
+  logger->error(TAG, "Unix domain sockets are not supported on this platform");
+  return false;
+}
+
+void Server::run()
+{
+}
+
+#endif
+
+void Server::readJobs(ServerConnectionPtr connection)
+{
+  auto job = newJob(connection);
+  std::string line;
+  while (connection->readLine(line))
+  {
+    std::istringstream is(line);
+    std::string command;
+    is >> command;
+
+    if (command.empty())
+    {
+      continue;
+    }
+    else if (command == "program")
+    {
+      std::getline(is >> std::ws, job.program);
+      job.isPath = true;
+    }
+    else if (command == "image")
+    {
+      std::size_t size = 0;
+      if (!(is >> size) || !connection->readBytes(size, job.program))
+      {
+        sendMessage(*connection, NO_JOB, "error", "Incomplete image");
+        break;
+      }
+      job.isPath = false;
+    }
+    else if (command == "stats")
+    {
+      std::string format;
+      is >> format;
+      job.stats = true;
+      job.statsJson = format == "json";
+    }
+    else if (command == "cosim")
+    {
+      job.coSimulate = true;
+    }
+    else if (command == "limit")
+    {
+      std::string kind;
+      long long value = -1;
+      is >> kind >> value;
+      if (value < 0)
+      {
+        sendMessage(*connection, NO_JOB, "error", "Invalid limit: " + line);
+      }
+      else if (kind == "cycles")
+      {
+        job.limits.cycles = static_cast<std::size_t>(value);
+      }
+      else if (kind == "time")
+      {
+        job.limits.time = std::chrono::milliseconds(value);
+      }
+      else if (kind == "deadlock")
+      {
+        job.limits.deadlockCycles = static_cast<std::size_t>(value);
+      }
+      else
+      {
+        sendMessage(*connection, NO_JOB, "error", "Unknown limit: " + kind);
+      }
+    }
+    else if (command == "run")
+    {
+      is >> job.id;
+      if (job.id.empty() || job.program.empty())
+      {
+        sendMessage(*connection, job.id.empty() ? NO_JOB : job.id, "error",
+          "A job needs an id and a program");
+      }
+      else
+      {
+        {
+          std::lock_guard<std::mutex> lock(jobsMutex);
+          jobs.push_back(job);
+        }
+        jobsReady.notify_one();
+      }
+      job = newJob(connection);
+    }
+    else
+    {
+      sendMessage(*connection, NO_JOB, "error",
+        "Unknown command: " + command);
+    }
+  }
+}
+
+Server::Job Server::newJob(ServerConnectionPtr connection) const
+{
+  return Job{ connection, "", "", true, false, false, false, defaultLimits };
+}
+
+void Server::work()
+{
+  MemoryPtr memory(new Memory(static_cast<UWord>(memorySize)));
+  // each job points output at its own buffer
+  std::ostream output(nullptr);
+  Tomasulo tomasulo(memory, false, false, 0, output);
+  while (true)
+  {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(jobsMutex);
+      jobsReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (stopping)
+      {
+        return;
+      }
+      job = jobs.front();
+      jobs.pop_front();
+    }
+
+    runJob(job, *memory, tomasulo, output);
+  }
+}
+
+void Server::runJob(const Job& job, Memory& memory, Tomasulo& tomasulo,
+  std::ostream& output)
+{
+  auto& connection = *job.connection;
+  JobOutputBuffer outputBuffer(connection, job.id);
+  output.rdbuf(&outputBuffer);
+  std::ostringstream diagnosis;
+  tomasulo.setDiagnosisOutput(diagnosis);
+  try
+  {
+    // a malformed program throws while loading, like any other failure
+    auto image = loadImage(job);
+    if (!image)
+    {
+      throw Exception("Unable to load the program");
+    }
+
+    tomasulo.reset();
+    memory.write(0, *image);
+    tomasulo.setCycleLimit(job.limits.cycles);
+    tomasulo.setTimeLimit(job.limits.time);
+    tomasulo.setDeadlockLimit(job.limits.deadlockCycles);
+    if (job.coSimulate)
+    {
+      tomasulo.enableCoSimulation();
+    }
+    tomasulo.run();
+    output.flush();
+    if (!diagnosis.str().empty())
+    {
+      sendMessage(connection, job.id, "diagnosis", diagnosis.str());
+    }
+
+    if (job.stats)
+    {
+      std::ostringstream stats;
+      if (job.statsJson)
+      {
+        tomasulo.counters().writeJson(stats);
+      }
+      else
+      {
+        tomasulo.counters().writeText(stats);
+      }
+      sendMessage(connection, job.id, "stats", stats.str());
+    }
+
+    std::ostringstream done;
+    done << job.id << " done " << tomasulo.clocks() << " " 
+      << tomasulo.outcome();
+    connection.send(done.str());
+  }
+  catch (std::exception& e)
+  {
+    output.flush();
+    sendMessage(connection, job.id, "error", e.what());
+  }
+  output.rdbuf(nullptr);
+  tomasulo.setDiagnosisOutput(output);
+}
+
+Pointer<const ByteBuffer> Server::loadImage(const Job& job)
+{
+  std::string key;
+  if (job.isPath)
+  {
+#if LU_COMPILER != LU_COMPILER_MSVC
+    // a program that changed on disk is loaded again
+    struct stat info;
+    if (stat(job.program.c_str(), &info) != 0)
+    {
+      return nullptr;
+    }
+    std::ostringstream os;
+    os << "path " << info.st_mtime << " " << info.st_size << " "
+      << job.program;
+    key = os.str();
+#endif
+  }
+  else
+  {
+    key = "image " + job.program;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(imagesMutex);
+    auto it = images.find(key);
+    if (it != images.end())
+    {
+      imageAges.splice(imageAges.begin(), imageAges, it->second.age);
+      return it->second.bytes;
+    }
+  }
+
+  Memory memory(static_cast<UWord>(memorySize));
+  bool loaded;
+  if (job.isPath)
+  {
+    loaded = loadFromFile(memory, job.program);
+  }
+  else
+  {
+    std::istringstream is(job.program);
+    loaded = loadFromStream(memory, is);
+  }
+  if (!loaded)
+  {
+    return nullptr;
+  }
+  // the zeros after the program are already in a reset memory
+  auto loadedBytes = memory.snapshot();
+  auto last = std::find_if(loadedBytes.rbegin(), loadedBytes.rend(),
+    [](Byte b) { return b != 0; });
+  loadedBytes.erase(last.base(), loadedBytes.end());
+  Pointer<const ByteBuffer> bytes(new ByteBuffer(std::move(loadedBytes)));
+
+  std::lock_guard<std::mutex> lock(imagesMutex);
+  if (images.find(key) == images.end())
+  {
+    imageAges.push_front(key);
+    images[key] = CachedImage{ bytes, imageAges.begin() };
+    while (images.size() > IMAGE_CACHE_SIZE)
+    {
+      images.erase(imageAges.back());
+      imageAges.pop_back();
+    }
+  }
+  return bytes;
+}
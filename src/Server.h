@@ -0,0 +1,149 @@
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include "types.h"
+#include <string>
+#include <ostream>
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+class Memory;
+class Tomasulo;
+class ServerConnection;
+using ServerConnectionPtr = Pointer<ServerConnection>;
+
+/**
+ * Runs simulation jobs sent over a Unix domain socket on a pool of worker
+ * threads, so a client can run many programs without starting a process for
+ * each.  Clients send newline terminated commands, and may queue any number
+ * of jobs on one connection:
+ *
+ *   program <path>     simulate the .hex file at path
+ *   image <n>          simulate the n bytes of .hex text that follow
+ *   stats text|json    send the statistics when the job finishes
+ *   cosim              check the job against the functional model
+ *   limit cycles <n>   stop the job after n cycles
+ *   limit time <ms>    stop the job after it has run for ms milliseconds
+ *   limit deadlock <n> stop the job after n cycles without progress
+ *   run <id>           queue the job described since the last run
+ *
+ * Replies are tagged with the job id, and the replies of different jobs may
+ * be interleaved.  Each job sends any number of output, stats and diagnosis
+ * messages, then ends with done or error:
+ *
+ *   <id> output <n>    followed by n bytes of trap output
+ *   <id> stats <n>     followed by n bytes of statistics
+ *   <id> diagnosis <n> followed by n bytes describing the machine state when
+ *                      a limit stopped the job
+ *   <id> done <cycles> <outcome>
+ *   <id> error <n>     followed by n bytes describing the failure
+ *
+ * The outcome is the rest of the done line, "finished" unless a limit 
+ * stopped the job.  Jobs start with the server's limits, and a limit of 0 
+ * turns one off.
+ *
+ * Loaded programs are kept between jobs, keyed by path and modification
+ * time, or by the image text.  Each worker runs all of its jobs on one
+ * processor, which is reset between them.
+ */
+class Server
+{
+public:
+  /**
+   * When a job is stopped before it finishes.  0 turns a limit off.
+   */
+  struct JobLimits
+  {
+    std::size_t cycles;
+    std::chrono::milliseconds time;
+    std::size_t deadlockCycles;
+  };
+
+private:
+  struct Job
+  {
+    ServerConnectionPtr connection;
+    std::string id;
+    // a path, or .hex text when isPath is not set
+    std::string program;
+    bool isPath;
+    bool stats;
+    bool statsJson;
+    bool coSimulate;
+    JobLimits limits;
+  };
+
+  struct CachedImage
+  {
+    Pointer<const ByteBuffer> bytes;
+    std::list<std::string>::iterator age;
+  };
+
+  const std::string socketPath;
+  const std::size_t numWorkers;
+  const std::size_t memorySize;
+  const JobLimits defaultLimits;
+  int listenSocket;
+
+  std::mutex jobsMutex;
+  std::condition_variable jobsReady;
+  std::deque<Job> jobs;
+  bool stopping;
+  std::vector<std::thread> workers;
+
+  std::mutex imagesMutex;
+  std::unordered_map<std::string, CachedImage> images;
+  // image keys, most recently used first
+  std::list<std::string> imageAges;
+
+public:
+  /**
+   * Jobs run on workers threads, each with memorySize bytes of memory, and 
+   * start with limits.
+   */
+  Server(const std::string& socketPath, std::size_t workers,
+    std::size_t memorySize, const JobLimits& limits);
+  Server(const Server&) = delete;
+  Server& operator=(const Server&) = delete;
+  ~Server();
+
+  /**
+   * Creates the socket, replacing any file at its path.  Returns false if
+   * the socket cannot be created.
+   */
+  bool listen();
+
+  /**
+   * Accepts connections until the socket fails.
+   */
+  void run();
+
+private:
+  void readJobs(ServerConnectionPtr connection);
+  /**
+   * A job on connection with the default settings.
+   */
+  Job newJob(ServerConnectionPtr connection) const;
+  void work();
+  /**
+   * Runs job on a worker's processor, which is reset first.  tomasulo uses 
+   * memory, and writes its trap output to output.
+   */
+  void runJob(const Job& job, Memory& memory, Tomasulo& tomasulo,
+    std::ostream& output);
+
+  /**
+   * Returns the memory image of the job's program, loading it unless it is
+   * cached.  The image ends at its last nonzero byte.  Returns nullptr if it 
+   * cannot be loaded.
+   */
+  Pointer<const ByteBuffer> loadImage(const Job& job);
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef __SIMULATIONEVENTS_H__
+#define __SIMULATIONEVENTS_H__
+
+#include "types.h"
+#include "RegisterID.h"
+#include "ReservationStationID.h"
+#include "instructions/Instruction.h"
+#include <functional>
+
+class SimulationEvents;
+using SimulationEventsPtr = Pointer<SimulationEvents>;
+
+/**
+ * Called when an instruction is issued to station in cycle clock.
+ */
+using IssueCallback = std::function<void(const ReservationStationID& station,
+  const Instruction& instruction, std::size_t clock)>;
+
+/**
+ * Called when the CDB commits the result of source to dest.
+ */
+using CommitCallback = std::function<void(const ReservationStationID& source,
+  const RegisterID& dest, Data value)>;
+
+/**
+ * Called when the instruction in station retires.
+ */
+using RetireCallback = std::function<void(const ReservationStationID& station,
+  const Instruction& instruction)>;
+
+/**
+ * The callbacks of a program embedding the simulator.  Unset callbacks are 
+ * skipped.
+ */
+class SimulationEvents
+{
+public:
+  IssueCallback issue;
+  CommitCallback commit;
+  RetireCallback retire;
+};
+
+#endif
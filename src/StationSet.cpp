@@ -0,0 +1,9 @@
+#include "StationSet.h"
+
+const std::size_t StationSet::npos;
+
+StationSet::StationSet(std::size_t capacity)
+  : count(0),
+    words((capacity + WORD_BITS - 1) / WORD_BITS, 0)
+{
+}
@@ -0,0 +1,111 @@
+#ifndef __STATIONSET_H__
+#define __STATIONSET_H__
+
+#include "types.h"
+#include "platform.h"
+#include <vector>
+#include <algorithm>
+#if LU_COMPILER == LU_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+/**
+ * A fixed capacity set of reservation station indices stored as a bitmask.  
+ * Finding the next member uses count trailing zeros, so walking the set costs 
+ * one step per member (plus one per 64 stations of capacity).
+ */
+class StationSet
+{
+public:
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+private:
+  static const std::size_t WORD_BITS = 64;
+
+  std::size_t count;
+  std::vector<uint64_t> words;
+
+public:
+  explicit StationSet(std::size_t capacity = 0);
+
+  void insert(std::size_t i)
+  {
+    auto& word = words[i / WORD_BITS];
+    auto bit = uint64_t(1) << (i % WORD_BITS);
+    count += (word & bit) == 0;
+    word |= bit;
+  }
+
+  void erase(std::size_t i)
+  {
+    auto& word = words[i / WORD_BITS];
+    auto bit = uint64_t(1) << (i % WORD_BITS);
+    count -= (word & bit) != 0;
+    word &= ~bit;
+  }
+
+  void clear()
+  {
+    std::fill(words.begin(), words.end(), 0);
+    count = 0;
+  }
+
+  bool contains(std::size_t i) const
+  {
+    return (words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+  }
+
+  bool empty() const
+  {
+    return count == 0;
+  }
+
+  std::size_t size() const
+  {
+    return count;
+  }
+
+  /**
+   * Returns the smallest member, or npos if the set is empty.
+   */
+  std::size_t first() const
+  {
+    return next(0);
+  }
+
+  /**
+   * Returns the smallest member >= i, or npos if there is none.
+   */
+  std::size_t next(std::size_t i) const
+  {
+    for (auto w = i / WORD_BITS; w < words.size(); w++)
+    {
+      auto word = words[w];
+      if (w == i / WORD_BITS)
+      {
+        // mask off members below i
+        word &= ~uint64_t(0) << (i % WORD_BITS);
+      }
+      if (word != 0)
+      {
+        return w * WORD_BITS + countTrailingZeros(word);
+      }
+    }
+
+    return npos;
+  }
+
+private:
+  static std::size_t countTrailingZeros(uint64_t word)
+  {
+#if LU_COMPILER == LU_COMPILER_MSVC
+    unsigned long idx;
+    _BitScanForward64(&idx, word);
+    return idx;
+#else
+    return __builtin_ctzll(word);
+#endif
+  }
+};
+
+#endif
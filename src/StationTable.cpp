@@ -0,0 +1,12 @@
+#include "StationTable.h"
+
+StationTable::StationTable(std::size_t numStations)
+  : states(numStations, ReservationStationState::Idle),
+    arg1Ready(numStations, false),
+    arg2Ready(numStations, false),
+    arg1Sources(numStations, ReservationStationID::NONE),
+    arg2Sources(numStations, ReservationStationID::NONE),
+    arg1(numStations),
+    arg2(numStations)
+{
+}
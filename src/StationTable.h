@@ -0,0 +1,40 @@
+#ifndef __STATIONTABLE_H__
+#define __STATIONTABLE_H__
+
+#include "types.h"
+#include "ReservationStationID.h"
+#include <vector>
+
+enum class ReservationStationState : uint8_t
+{
+  Idle,
+  WaitingForArgs,
+  ReadyToExecute,
+  Executing,
+  ExecutionComplete,
+  Writing,
+  WriteComplete
+};
+
+/**
+ * Structure-of-arrays storage for the frequently accessed fields of one 
+ * functional unit's reservation stations, indexed by station index.  The 
+ * functional unit walks its stage sets and reads the states here, without 
+ * going through each station.
+ */
+struct StationTable
+{
+  explicit StationTable(std::size_t numStations);
+  StationTable(const StationTable&) = delete;
+  StationTable& operator=(const StationTable&) = delete;
+
+  std::vector<ReservationStationState> states;
+  std::vector<uint8_t> arg1Ready;
+  std::vector<uint8_t> arg2Ready;
+  std::vector<ReservationStationID> arg1Sources;
+  std::vector<ReservationStationID> arg2Sources;
+  std::vector<Data> arg1;
+  std::vector<Data> arg2;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "Tomasulo.h"
+#include "MachineConfig.h"
 #include "log.h"
 #include "instructions/Instruction.h"
 #include "utility/stream_manip.h"
@@ -6,140 +7,665 @@
 #include <string>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <algorithm>
 
 static const std::string TAG = "Tomasulo";
 
-// machine configuration
-static const int GPR_REGISTERS = 32;
-static const int FPR_REGISTERS = 32;
+// registers of each type shown in the verbose dump
+static const std::size_t DUMP_REGISTERS = 8;
 
-static const int INTEGER_CYCLES = 1;
-static const int INTEGER_STATIONS = 8;
-static const int INTEGER_UNITS = 3;
-
-static const int TRAP_CYCLES = 1;
-static const int TRAP_STATIONS = 4;
-static const int TRAP_UNITS = 1;
-
-static const int BRANCH_CYCLES = 1;
-static const int BRANCH_STATIONS = 1;
-static const int BRANCH_UNITS = 1;
-
-static const int MEMORY_CYCLES = 2;
-static const int MEMORY_STATIONS = 8;
-static const int MEMORY_UNITS = 1;
-
-static const int FLOAT_CYCLES = 4;
-static const int FLOAT_STATIONS = 8;
-static const int FLOAT_UNITS = 2;
-
-Tomasulo::Tomasulo(MemoryPtr memory, bool verbose)
+Tomasulo::Tomasulo(MemoryPtr memory, bool verbose, bool deltaDump,
+  std::size_t keyframeInterval, std::ostream& output)
   : verbose(verbose),
+    deltaDump(deltaDump),
+    keyframeInterval(keyframeInterval),
+    output(output),
     instructionFactory(nullptr),
     halted(false),
     stallIssue(false),
+    issueCategory(CPICategory::Base),
+    issueBlockedType(FunctionalUnitType::None),
     clockCounter(0),
     pc(0),
     memory(memory),
     registerFile(nullptr),
     renameRegisterFile(nullptr),
     commonDataBus(nullptr),
-    functionalUnits()
+    perfCounters(new PerformanceCounters),
+    stationDeps(nullptr),
+    hostProfile(nullptr),
+    replayTrace(nullptr),
+    replayRecord(),
+    coSimulate(false),
+    coSimulation(nullptr),
+    events(nullptr),
+    fastForwardLoops(false),
+    fastForward(nullptr),
+    started(false),
+    ended(false),
+    cycleLimit(0),
+    timeLimit(0),
+    deadlockLimit(0),
+    limited(false),
+    runStart(),
+    checkClock(0),
+    lastActivity(0),
+    idleCycles(0),
+    longestIdleCycles(0),
+    runOutcome(RunOutcome::Finished),
+    diagnosisOutput(&output),
+    functionalUnits(),
+    dumpedPC(0),
+    dumpedStallIssue(false),
+    dumpedHalted(false),
+    dumpedRenames(DUMP_REGISTERS * 2, ReservationStationID::NONE),
+    dumpedRegisters(DUMP_REGISTERS * 2, 0)
 {
   assert(memory != nullptr);
 
   registerFile = RegisterFilePtr(
     new RegisterFile(GPR_REGISTERS, FPR_REGISTERS)
     );
-  renameRegisterFile = RenameRegisterFilePtr(new RenameRegisterFile);
+  renameRegisterFile = RenameRegisterFilePtr(
+    new RenameRegisterFile(GPR_REGISTERS, FPR_REGISTERS)
+    );
   commonDataBus = CommonDataBusPtr(
-    new CommonDataBus(registerFile, renameRegisterFile)
+    new CommonDataBus(registerFile, renameRegisterFile, perfCounters)
     );
   instructionFactory = InstructionFactoryPtr(
-    new InstructionFactory(pc, memory, registerFile)
+    new InstructionFactory(pc, memory, registerFile, output)
     );
 
   // create all functional units
-  ReservationStationDependencies deps(
-    registerFile, renameRegisterFile, memory, pc, stallIssue, commonDataBus
+  stationDeps = Pointer<ReservationStationDependencies>(
+    new ReservationStationDependencies(
+      registerFile, renameRegisterFile, memory, pc, stallIssue, clockCounter,
+      commonDataBus, perfCounters
+      )
     );
+  auto& deps = *stationDeps;
   functionalUnits[FunctionalUnitType::Integer] = 
     FunctionalUnitPtr(
       new FunctionalUnit(
         FunctionalUnitType::Integer, false, INTEGER_CYCLES, 
-        INTEGER_STATIONS, INTEGER_UNITS, deps
+        INTEGER_STATIONS, INTEGER_UNITS, deps, perfCounters
         )
     );
   functionalUnits[FunctionalUnitType::Trap] =
     FunctionalUnitPtr(
       new FunctionalUnit(
         FunctionalUnitType::Trap, true, TRAP_CYCLES,
-        TRAP_STATIONS, TRAP_UNITS, deps
+        TRAP_STATIONS, TRAP_UNITS, deps, perfCounters
         )
     );
   functionalUnits[FunctionalUnitType::Branch] =
     FunctionalUnitPtr(
       new FunctionalUnit(
         FunctionalUnitType::Branch, true, BRANCH_CYCLES,
-        BRANCH_STATIONS, BRANCH_UNITS, deps
+        BRANCH_STATIONS, BRANCH_UNITS, deps, perfCounters
         )
     );
   functionalUnits[FunctionalUnitType::Memory] =
     FunctionalUnitPtr(
       new FunctionalUnit(
         FunctionalUnitType::Memory, true, MEMORY_CYCLES, 
-        MEMORY_STATIONS, MEMORY_UNITS, deps
+        MEMORY_STATIONS, MEMORY_UNITS, deps, perfCounters
         )
     );
   functionalUnits[FunctionalUnitType::FloatingPoint] =
     FunctionalUnitPtr(
       new FunctionalUnit(
         FunctionalUnitType::FloatingPoint, false, FLOAT_CYCLES,
-        FLOAT_STATIONS, FLOAT_UNITS, deps
+        FLOAT_STATIONS, FLOAT_UNITS, deps, perfCounters
         )
     );
 }
 
+std::ostream& operator<<(std::ostream& os, RunOutcome outcome)
+{
+  switch (outcome)
+  {
+  case RunOutcome::Finished:
+    os << "finished";
+    break;
+
+  case RunOutcome::CycleLimit:
+    os << "cycle limit reached";
+    break;
+
+  case RunOutcome::TimeLimit:
+    os << "time limit reached";
+    break;
+
+  case RunOutcome::Deadlock:
+    os << "no progress, deadlocked";
+    break;
+  }
+  return os;
+}
+
 bool Tomasulo::isHalted() const
 {
   return halted;
 }
 
+bool Tomasulo::isFinished() const
+{
+  return halted && functionalUnitsIdle();
+}
+
+Address Tomasulo::getPC() const
+{
+  return pc;
+}
+
+const RegisterFile& Tomasulo::getRegisters() const
+{
+  return *registerFile;
+}
+
+ReservationStationID Tomasulo::getRenaming(const RegisterID& reg) const
+{
+  return renameRegisterFile->getRenaming(reg);
+}
+
+ReservationStationState Tomasulo::getStationState(
+  const ReservationStationID& station) const
+{
+  auto fu = functionalUnits.find(station.type);
+  assert(fu != functionalUnits.end());
+  return fu->second->getStation(station.index).getState();
+}
+
+const Memory& Tomasulo::getMemory() const
+{
+  return *memory;
+}
+
 std::size_t Tomasulo::clocks() const
 {
   return clockCounter;
 }
 
-void Tomasulo::run(Address entryPoint)
+const PerformanceCounters& Tomasulo::counters() const
+{
+  return *perfCounters;
+}
+
+void Tomasulo::enablePCProfile()
+{
+  perfCounters->pcProfile = PCProfilePtr(new PCProfile(memory->size()));
+}
+
+void Tomasulo::enableCPIStack(std::size_t interval)
+{
+  perfCounters->cpiStack = CPIStackPtr(new CPIStack(interval));
+}
+
+void Tomasulo::enablePipelineTrace(std::size_t capacity)
+{
+  perfCounters->pipelineTrace = PipelineTracePtr(new PipelineTrace(capacity));
+  stationDeps->trace = perfCounters->pipelineTrace;
+}
+
+void Tomasulo::enableOccupancy()
+{
+  std::size_t totalStations = 0;
+  for (const auto& fu : functionalUnits)
+  {
+    totalStations += perfCounters->getFunctionalUnit(fu.first).numStations;
+  }
+
+  auto occupancy = OccupancyPtr(new Occupancy(totalStations));
+  for (const auto& fu : functionalUnits)
+  {
+    const auto& unit = perfCounters->getFunctionalUnit(fu.first);
+    occupancy->addFunctionalUnit(fu.first, unit.numStations, 
+      unit.numExecuteUnits);
+  }
+  perfCounters->occupancy = occupancy;
+}
+
+void Tomasulo::enableIntervalStats(std::ostream& os, IntervalUnit unit, 
+  std::size_t length, IntervalFormat format)
+{
+  perfCounters->intervalStats = IntervalStatsPtr(
+    new IntervalStats(os, unit, length, format)
+    );
+}
+
+void Tomasulo::setHostProfile(HostProfilePtr profile)
 {
+  hostProfile = profile;
+}
+
+void Tomasulo::setDataflowLog(DataflowLogPtr log)
+{
+  stationDeps->dataflow = log;
+}
+
+void Tomasulo::setReplayTrace(TraceReaderPtr trace)
+{
+  replayTrace = trace;
+  stationDeps->replay = trace != nullptr;
+}
+
+void Tomasulo::enableCoSimulation()
+{
+  coSimulate = true;
+}
+
+void Tomasulo::enableFastForward()
+{
+  fastForwardLoops = true;
+}
+
+void Tomasulo::setCycleLimit(std::size_t cycles)
+{
+  cycleLimit = cycles;
+  limited = cycleLimit > 0 || timeLimit.count() > 0 || deadlockLimit > 0;
+}
+
+void Tomasulo::setTimeLimit(std::chrono::milliseconds limit)
+{
+  timeLimit = limit;
+  limited = cycleLimit > 0 || timeLimit.count() > 0 || deadlockLimit > 0;
+}
+
+void Tomasulo::setDeadlockLimit(std::size_t cycles)
+{
+  deadlockLimit = cycles;
+  limited = cycleLimit > 0 || timeLimit.count() > 0 || deadlockLimit > 0;
+}
+
+void Tomasulo::setDiagnosisOutput(std::ostream& os)
+{
+  diagnosisOutput = &os;
+}
+
+RunOutcome Tomasulo::outcome() const
+{
+  return runOutcome;
+}
+
+std::size_t Tomasulo::longestIdle() const
+{
+  return deadlockLimit > 0 ? longestIdleCycles 
+    : std::numeric_limits<std::size_t>::max();
+}
+
+void Tomasulo::setIssueCallback(IssueCallback callback)
+{
+  getEvents().issue = callback;
+}
+
+void Tomasulo::setCommitCallback(CommitCallback callback)
+{
+  getEvents().commit = callback;
+}
+
+void Tomasulo::setRetireCallback(RetireCallback callback)
+{
+  getEvents().retire = callback;
+}
+
+void Tomasulo::start(Address entryPoint)
+{
+  assert(!started);
+  started = true;
+
   pc = entryPoint;
+  if (coSimulate)
+  {
+    assert(!replayTrace);
+    coSimulation = CoSimulationPtr(new CoSimulation(*memory, entryPoint));
+    stationDeps->coSimulation = coSimulation;
+    commonDataBus->setCoSimulation(coSimulation);
+  }
+  if (replayTrace)
+  {
+    nextReplayRecord();
+    entryPoint = pc;
+  }
+  if (fastForwardLoops)
+  {
+    if (verbose || replayTrace || coSimulation || events 
+      || perfCounters->pcProfile || perfCounters->cpiStack 
+      || perfCounters->pipelineTrace || perfCounters->occupancy 
+      || perfCounters->intervalStats || stationDeps->dataflow)
+    {
+      logger->warning(TAG, "Loops are not skipped while every cycle is "
+        "recorded");
+    }
+    else
+    {
+      fastForward = FastForwardPtr(new FastForward(memory, registerFile, 
+        renameRegisterFile, perfCounters, entryPoint));
+      for (const auto& fu : functionalUnits)
+      {
+        fastForward->addFunctionalUnit(fu.second);
+      }
+      stationDeps->fastForward = fastForward;
+      commonDataBus->setFastForward(fastForward);
+    }
+  }
 
   logger->debug(TAG) << "Executing from address "
     << util::hex<Address> << entryPoint << "\n";
 
-  while (!halted || !functionalUnitsIdle())
+  if (hostProfile)
+  {
+    hostProfile->start();
+  }
+}
+
+std::size_t Tomasulo::step(std::size_t cycles)
+{
+  if (!started)
+  {
+    start();
+  }
+
+  std::size_t count = 0;
+  while (count < cycles && !isFinished())
+  {
+    cycle();
+    count++;
+  }
+  if (isFinished())
+  {
+    finish();
+  }
+  return count;
+}
+
+bool Tomasulo::runUntil(const std::function<bool(const Tomasulo&)>& done)
+{
+  if (!started)
+  {
+    start();
+  }
+
+  while (!isFinished())
+  {
+    if (done(*this))
+    {
+      return true;
+    }
+    cycle();
+  }
+  finish();
+  return done(*this);
+}
+
+bool Tomasulo::runUntilCycle(std::size_t clock)
+{
+  return runUntil([clock](const Tomasulo& t) { return t.clocks() >= clock; });
+}
+
+bool Tomasulo::runUntilPC(Address address)
+{
+  return runUntil([address](const Tomasulo& t) { 
+    return t.getPC() == address; 
+  });
+}
+
+void Tomasulo::run(Address entryPoint)
+{
+  if (!started)
+  {
+    start(entryPoint);
+  }
+
+  runOutcome = RunOutcome::Finished;
+  if (limited)
+  {
+    runStart = std::chrono::steady_clock::now();
+    checkClock = clockCounter;
+    lastActivity = activity();
+    idleCycles = 0;
+    longestIdleCycles = 0;
+  }
+  while (!isFinished())
+  {
+    cycle();
+    // a program that finishes on the last cycle allowed was not stopped
+    if (limited && !isFinished() && !withinLimits())
+    {
+      logger->warning(TAG) << "Stopped at cycle " << clockCounter << ": " 
+        << runOutcome;
+      dumpDiagnosis(*diagnosisOutput);
+      break;
+    }
+  }
+  finish();
+}
+
+void Tomasulo::reset()
+{
+  memory->clear();
+  registerFile->reset();
+  renameRegisterFile->reset();
+  commonDataBus->reset();
+  perfCounters->reset();
+  for (const auto& fu : functionalUnits)
+  {
+    fu.second->reset();
+  }
+  stationDeps->trace = nullptr;
+  stationDeps->dataflow = nullptr;
+  stationDeps->coSimulation = nullptr;
+  stationDeps->events = nullptr;
+  stationDeps->fastForward = nullptr;
+  stationDeps->replay = false;
+
+  halted = false;
+  stallIssue = false;
+  issueCategory = CPICategory::Base;
+  issueBlockedType = FunctionalUnitType::None;
+  clockCounter = 0;
+  pc = 0;
+  hostProfile = nullptr;
+  replayTrace = nullptr;
+  replayRecord = TraceRecord();
+  coSimulate = false;
+  coSimulation = nullptr;
+  events = nullptr;
+  fastForwardLoops = false;
+  fastForward = nullptr;
+  started = false;
+  ended = false;
+  cycleLimit = 0;
+  timeLimit = std::chrono::steady_clock::duration(0);
+  deadlockLimit = 0;
+  limited = false;
+  checkClock = 0;
+  lastActivity = 0;
+  idleCycles = 0;
+  longestIdleCycles = 0;
+  runOutcome = RunOutcome::Finished;
+  dumpedPC = 0;
+  dumpedStallIssue = false;
+  dumpedHalted = false;
+  std::fill(dumpedRenames.begin(), dumpedRenames.end(), 
+    ReservationStationID::NONE);
+  std::fill(dumpedRegisters.begin(), dumpedRegisters.end(), 0);
+}
+
+void Tomasulo::cycle()
+{
+  ++clockCounter;
+  logger->info(TAG) << "****CLOCK CYCLE " << clockCounter << " BEGIN****";
+  if (perfCounters->pipelineTrace)
+  {
+    perfCounters->pipelineTrace->setClock(clockCounter);
+  }
+  if (coSimulation)
+  {
+    coSimulation->setClock(clockCounter);
+  }
+  
+  advanceInstructions();            
+  lap(HostStage::AdvanceInstructions);
+  issue();
+  lap(HostStage::Issue);
+  execute();
+  lap(HostStage::Execute);
+  write();
+  lap(HostStage::Write);
+  updateCounters();
+  if (fastForward)
+  {
+    // a skip may not pass the cycle limit
+    auto maxCycles = std::numeric_limits<std::size_t>::max();
+    if (cycleLimit > 0)
+    {
+      maxCycles = cycleLimit > clockCounter ? cycleLimit - clockCounter : 0;
+    }
+    clockCounter += fastForward->endCycle(clockCounter, pc, stallIssue, 
+      maxCycles);
+  }
+  lap(HostStage::Counters);
+
+  dumpState();        
+  logger->info(TAG) << "****CLOCK CYCLE " << clockCounter << " END****\n";
+  lap(HostStage::DumpState);
+}
+
+void Tomasulo::finish()
+{
+  if (ended)
+  {
+    return;
+  }
+  ended = true;
+
+  if (perfCounters->intervalStats)
+  {
+    perfCounters->intervalStats->finish(*perfCounters);
+  }
+  if (fastForward)
+  {
+    logger->info(TAG) << "Skipped " << fastForward->loopsSkipped() 
+      << " loops, " << fastForward->iterationsSkipped() << " iterations and "
+      << fastForward->cyclesSkipped() << " cycles";
+  }
+  // a run stopped at a limit has not reached its final state
+  if (coSimulation && runOutcome == RunOutcome::Finished)
+  {
+    coSimulation->finish(*registerFile);
+  }
+}
+
+bool Tomasulo::withinLimits()
+{
+  // reading the host clock or every unit's activity each cycle would be too 
+  // slow
+  static const std::size_t CHECK_INTERVAL = 1024;
+
+  if (cycleLimit > 0 && clockCounter >= cycleLimit)
+  {
+    runOutcome = RunOutcome::CycleLimit;
+    return false;
+  }
+
+  // counted from the last check, since a fast forward can skip any number of 
+  // cycles
+  auto elapsed = clockCounter - checkClock;
+  if (elapsed < CHECK_INTERVAL)
+  {
+    return true;
+  }
+  checkClock = clockCounter;
+
+  if (timeLimit.count() > 0 
+    && std::chrono::steady_clock::now() - runStart >= timeLimit)
+  {
+    runOutcome = RunOutcome::TimeLimit;
+    return false;
+  }
+  if (deadlockLimit > 0)
+  {
+    auto current = activity();
+    if (current != lastActivity)
+    {
+      lastActivity = current;
+      idleCycles = 0;
+    }
+    else
+    {
+      idleCycles += elapsed;
+      longestIdleCycles = std::max(longestIdleCycles, idleCycles);
+      if (idleCycles >= deadlockLimit)
+      {
+        runOutcome = RunOutcome::Deadlock;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+uint64_t Tomasulo::activity() const
+{
+  // every counter only grows, so the sum changes whenever any of them does
+  uint64_t total = perfCounters->cdbGrants + perfCounters->issued() 
+    + perfCounters->retired();
+  for (const auto& fu : functionalUnits)
   {
-    ++clockCounter;
-    logger->info(TAG) << "****CLOCK CYCLE " << clockCounter << " BEGIN****";
-    
-    advanceInstructions();            
-    issue();
-    execute();
-    write();
+    total += perfCounters->getFunctionalUnit(fu.first).executeBusyCycles;
+  }
+  return total;
+}
 
-    dumpState();        
-    logger->info(TAG) << "****CLOCK CYCLE " << clockCounter << " END****\n";
+void Tomasulo::dumpDiagnosis(std::ostream& os)
+{
+  // the dump switches to hex, and the program's output may carry on after it
+  auto flags = os.flags();
+  auto fill = os.fill();
+  os << "\nStopped at clock cycle " << std::dec << clockCounter 
+    << ": " << runOutcome << std::endl;
+  os << "\t" << "PC=" << util::hex<Address> << pc << std::endl;
+  os << "\t" << "Issue Stalled=" << (stallIssue ? "Y" : "N") 
+    << std::endl;
+  os << "\t" << "Halted=" << (halted ? "Y" : "N") << std::endl;
+  os << "\t" << "Cycles Without Progress=" << std::dec << idleCycles 
+    << std::endl;
+  for (const auto& fu : functionalUnits)
+  {
+    fu.second->dumpState(os);
   }
+  commonDataBus->dumpState(os);
+  dumpRegisters(true, os);
+  os.flags(flags);
+  os.fill(fill);
 }
 
 void Tomasulo::issue()
 {
   logger->debug(TAG, "**ISSUE BEGIN**");  
 
+  // resolved branches write their (unexecuted) target to the PC
+  if (replayTrace)
+  {
+    pc = replayRecord.address;
+  }
+
+  PCCounters* pcCounters = nullptr;
+  if (perfCounters->pcProfile)
+  {
+    pcCounters = &perfCounters->pcProfile->at(pc);
+    pcCounters->issueCycles++;
+  }
+  issueCategory = CPICategory::Base;
+  issueBlockedType = FunctionalUnitType::None;
+
   if (!halted && !stallIssue)
   {
     bool advancePC = true;
-    UWord rawInstruction = memory->readUWord(pc);
+    UWord rawInstruction = replayTrace ? replayRecord.instruction 
+      : memory->readUWord(pc);
     InstructionPtr instruction = instructionFactory->decode(rawInstruction);
     assert(instruction);
 
@@ -151,12 +677,33 @@ void Tomasulo::issue()
     {
       halted = true;
       logger->info(TAG, "Halting when issued instructions are completed");
+      if (coSimulation)
+      {
+        coSimulation->halt(pc);
+      }
       advancePC = false;
+      issueCategory = CPICategory::Drain;
     }
     else
     {
       auto fu = functionalUnits[instruction->getType()];
       advancePC = fu->issue(instruction, clockCounter);
+      if (advancePC)
+      {
+        if (pcCounters)
+        {
+          pcCounters->issued++;
+        }
+      }
+      else
+      {
+        issueCategory = CPICategory::Stations;
+        issueBlockedType = instruction->getType();
+        if (pcCounters)
+        {
+          pcCounters->stationsFullStalls++;
+        }
+      }
     }
 
     if (advancePC)
@@ -169,6 +716,10 @@ void Tomasulo::issue()
       {
         pc += 4;
       }
+      if (replayTrace)
+      {
+        nextReplayRecord();
+      }
     }
     else
     {
@@ -178,11 +729,42 @@ void Tomasulo::issue()
   else
   {
     logger->debug(TAG, "Issue stalled");
+    if (halted)
+    {
+      issueCategory = CPICategory::Drain;
+      perfCounters->haltedStalls++;
+      if (pcCounters)
+      {
+        pcCounters->haltedStalls++;
+      }
+    }
+    else
+    {
+      issueCategory = CPICategory::Branch;
+      perfCounters->branchStalls++;
+      if (pcCounters)
+      {
+        pcCounters->branchStalls++;
+      }
+    }
   }  
 
   logger->debug(TAG, "**ISSUE END**");
 }
 
+void Tomasulo::nextReplayRecord()
+{
+  if (replayTrace->next(replayRecord))
+  {
+    pc = replayRecord.address;
+  }
+  else
+  {
+    logger->warning(TAG, "Trace ended without halting");
+    halted = true;
+  }
+}
+
 void Tomasulo::execute()
 {
   logger->debug(TAG, "**EXECUTE BEGIN**");
@@ -212,6 +794,49 @@ void Tomasulo::advanceInstructions()
   }
 }
 
+void Tomasulo::updateCounters()
+{
+  perfCounters->cycles++;
+  for (auto& fu : functionalUnits)
+  {
+    fu.second->updateCounters();
+  }
+
+  if (perfCounters->cpiStack)
+  {
+    auto category = issueCategory;
+    if (category == CPICategory::Stations)
+    {
+      category = functionalUnits[issueBlockedType]->stallCategory();
+    }
+    perfCounters->cpiStack->endCycle(category, issueBlockedType, 
+      perfCounters->retired());
+  }
+  if (perfCounters->intervalStats)
+  {
+    perfCounters->intervalStats->endCycle(*perfCounters);
+  }
+}
+
+void Tomasulo::lap(HostStage stage)
+{
+  if (hostProfile)
+  {
+    hostProfile->lap(stage);
+  }
+}
+
+SimulationEvents& Tomasulo::getEvents()
+{
+  if (!events)
+  {
+    events = SimulationEventsPtr(new SimulationEvents);
+    stationDeps->events = events;
+    commonDataBus->setEvents(events);
+  }
+  return *events;
+}
+
 bool Tomasulo::functionalUnitsIdle() const
 {
   for (auto fu : functionalUnits)
@@ -225,61 +850,101 @@ bool Tomasulo::functionalUnitsIdle() const
   return true;
 }
 
-void Tomasulo::dumpState() const
+void Tomasulo::dumpState()
 {
   if (!verbose)
   {
     return;
   }
 
+  bool full = !deltaDump || clockCounter == 1 
+    || (keyframeInterval > 0 && clockCounter % keyframeInterval == 0);
+
   std::cout << "\nClock cycle: " << std::dec << clockCounter << std::endl;
-  std::cout << "\t" << "PC=" << util::hex<Address> << pc << std::endl;
-  std::cout << "\t" << "Issue Stalled=" << (stallIssue ? "Y" : "N") << std::endl;
-  std::cout << "\t" << "Halted=" << (halted ? "Y" : "N") << std::endl;
+  if (full || pc != dumpedPC)
+  {
+    std::cout << "\t" << "PC=" << util::hex<Address> << pc << std::endl;
+  }
+  if (full || stallIssue != dumpedStallIssue)
+  {
+    std::cout << "\t" << "Issue Stalled=" << (stallIssue ? "Y" : "N") 
+      << std::endl;
+  }
+  if (full || halted != dumpedHalted)
+  {
+    std::cout << "\t" << "Halted=" << (halted ? "Y" : "N") << std::endl;
+  }
+  dumpedPC = pc;
+  dumpedStallIssue = stallIssue;
+  dumpedHalted = halted;
 
   for (auto fu : functionalUnits)
   {
-    fu.second->dumpState();
+    fu.second->dumpChanges(full);
   }
 
-  commonDataBus->dumpState();
-  dumpRegisters();
+  commonDataBus->dumpChanges(full);
+  dumpRegisters(full);
 }
 
-void Tomasulo::dumpRegisters() const
+void Tomasulo::dumpRegisters(bool full, std::ostream& os)
 {
-  RegisterID reg = RegisterID::R0;
-
-  std::cout << "R0-R7: ";
-  for (std::size_t i = 0; i < 8; i++)
+  bool changed = false;
+  for (std::size_t i = 0; i < DUMP_REGISTERS * 2; i++)
   {
-    reg.index = i;
+    RegisterID reg = { 
+      i < DUMP_REGISTERS ? RegisterType::GPR : RegisterType::FPR,
+      i % DUMP_REGISTERS 
+    };
     auto rename = renameRegisterFile->getRenaming(reg);
-    if (rename == ReservationStationID::NONE)
+    auto value = registerFile->read(reg).uw;
+
+    if (full)
     {
-      std::cout << util::hex<UWord> << registerFile->read(reg).uw << " ";
+      if (i == 0)
+      {
+        os << "R0-R7: ";
+      }
+      else if (i == DUMP_REGISTERS)
+      {
+        os << std::endl << "F0-F7: ";
+      }
+
+      if (rename == ReservationStationID::NONE)
+      {
+        os << util::hex<UWord> << value << " ";
+      }
+      else
+      {
+        os << rename << " ";
+      }
     }
-    else
+    else if (rename != dumpedRenames[i] 
+      || (rename == ReservationStationID::NONE && value != dumpedRegisters[i]))
     {
-      std::cout << rename << " ";
+      if (!changed)
+      {
+        os << "Registers:";
+        changed = true;
+      }
+
+      os << " " << reg << "=";
+      if (rename == ReservationStationID::NONE)
+      {
+        os << util::hex<UWord> << value;
+      }
+      else
+      {
+        os << rename;
+      }
     }
+
+    dumpedRenames[i] = rename;
+    dumpedRegisters[i] = value;
   }
-  std::cout << std::endl;
 
-  reg.type = RegisterType::FPR;
-  std::cout << "F0-F7: ";
-  for (std::size_t i = 0; i < 8; i++)
+  if (full || changed)
   {
-    reg.index = i;
-    auto rename = renameRegisterFile->getRenaming(reg);
-    if (rename == ReservationStationID::NONE)
-    {
-      std::cout << util::hex<UWord> << registerFile->read(reg).uw << " ";
-    }
-    else
-    {
-      std::cout << rename << " ";
-    }
+    os << std::endl;
   }
-  std::cout << std::endl;
 }
@@ -8,17 +8,46 @@
 #include "RenameRegisterFile.h"
 #include "CommonDataBus.h"
 #include "FunctionalUnit.h"
+#include "PerformanceCounters.h"
+#include "HostProfile.h"
+#include "InstructionTrace.h"
+#include "CoSimulation.h"
+#include "SimulationEvents.h"
+#include "FastForward.h"
 #include <unordered_map>
+#include <functional>
+#include <chrono>
+#include <ostream>
+#include <iostream>
+
+/**
+ * Why run() returned.
+ */
+enum class RunOutcome
+{
+  Finished,
+  CycleLimit,
+  TimeLimit,
+  Deadlock
+};
+
+std::ostream& operator<<(std::ostream& os, RunOutcome outcome);
 
 class Tomasulo
 {
 private:
   // general
   bool verbose;
+  bool deltaDump;
+  std::size_t keyframeInterval;
+  std::ostream& output;
   InstructionFactoryPtr instructionFactory;
   // machine state
   bool halted;
   bool stallIssue;
+  // what the issue stage did this cycle
+  CPICategory issueCategory;
+  FunctionalUnitType issueBlockedType;
   std::size_t clockCounter;
   Address pc;
   // components
@@ -26,25 +55,234 @@ private:
   RegisterFilePtr registerFile;
   RenameRegisterFilePtr renameRegisterFile;
   CommonDataBusPtr commonDataBus;
+  PerformanceCountersPtr perfCounters;
+  Pointer<ReservationStationDependencies> stationDeps;
+  HostProfilePtr hostProfile;
+  // the instructions to issue when replaying a trace, and the next of them
+  TraceReaderPtr replayTrace;
+  TraceRecord replayRecord;
+  // checks the run against the functional model, created by run()
+  bool coSimulate;
+  CoSimulationPtr coSimulation;
+  // callbacks of an embedding program, created when the first is set
+  SimulationEventsPtr events;
+  // skips periodic loop iterations, created by start()
+  bool fastForwardLoops;
+  FastForwardPtr fastForward;
+  // whether start() and finish() have been called
+  bool started;
+  bool ended;
+  // limits on run(), 0 for none
+  std::size_t cycleLimit;
+  std::chrono::steady_clock::duration timeLimit;
+  std::size_t deadlockLimit;
+  bool limited;
+  std::chrono::steady_clock::time_point runStart;
+  // the clock when the time and progress limits were last checked
+  std::size_t checkClock;
+  // the activity counted at the last check with progress, and the cycles 
+  // since
+  uint64_t lastActivity;
+  std::size_t idleCycles;
+  std::size_t longestIdleCycles;
+  RunOutcome runOutcome;
+  std::ostream* diagnosisOutput;
   std::unordered_map<FunctionalUnitType, FunctionalUnitPtr, FunctionalUnitTypeHash>
     functionalUnits;
+  // values printed by the last verbose dump
+  Address dumpedPC;
+  bool dumpedStallIssue;
+  bool dumpedHalted;
+  std::vector<ReservationStationID> dumpedRenames;
+  std::vector<UWord> dumpedRegisters;
 
 public:
-  explicit Tomasulo(MemoryPtr memory, bool verbose = false);
+  /**
+   * When deltaDump is set, the verbose output after each cycle only contains 
+   * the state that changed during that cycle, with the full state printed on 
+   * the first cycle and every keyframeInterval cycles (0 disables keyframes).
+   * The program's trap output is written to output.
+   */
+  explicit Tomasulo(MemoryPtr memory, bool verbose = false, 
+    bool deltaDump = false, std::size_t keyframeInterval = 0,
+    std::ostream& output = std::cout);
 
   bool isHalted() const;
+  /**
+   * Whether the program has halted and every issued instruction completed.
+   */
+  bool isFinished() const;
   std::size_t clocks() const;
+  const PerformanceCounters& counters() const;
+  Address getPC() const;
+  const RegisterFile& getRegisters() const;
+  ReservationStationID getRenaming(const RegisterID& reg) const;
+  ReservationStationState getStationState(
+    const ReservationStationID& station) const;
+  const Memory& getMemory() const;
+
+  /**
+   * Starts attributing cycles to instruction addresses, available through 
+   * counters().pcProfile.
+   */
+  void enablePCProfile();
+
+  /**
+   * Starts splitting cycles into a CPI stack, available through 
+   * counters().cpiStack.  interval is the length of each interval in cycles, 
+   * 0 for a whole run breakdown only.
+   */
+  void enableCPIStack(std::size_t interval = 0);
+
+  /**
+   * Starts recording the lifecycle of the last capacity instructions, 
+   * available through counters().pipelineTrace.
+   */
+  void enablePipelineTrace(std::size_t capacity);
+
+  /**
+   * Starts collecting per cycle occupancy histograms, available through 
+   * counters().occupancy.
+   */
+  void enableOccupancy();
+
+  /**
+   * Starts writing statistics to os every length cycles or retired 
+   * instructions while the program runs.  os must stay open until run() 
+   * returns.
+   */
+  void enableIntervalStats(std::ostream& os, IntervalUnit unit, 
+    std::size_t length, IntervalFormat format);
+
+  /**
+   * Times each stage of the simulation loop into profile.
+   */
+  void setHostProfile(HostProfilePtr profile);
+
+  /**
+   * Records the sources and latency of every issued instruction to log.
+   */
+  void setDataflowLog(DataflowLogPtr log);
+
+  /**
+   * Issues the instructions of trace instead of fetching them from memory.  
+   * Instructions are timed as usual, but are not executed, so memory and the 
+   * registers do not change and traps print nothing.
+   */
+  void setReplayTrace(TraceReaderPtr trace);
+
+  /**
+   * Runs the functional model in lockstep, checking every register write 
+   * and store, and throwing a DivergenceException at the first difference.  
+   * Cannot be combined with a replayed trace.
+   */
+  void enableCoSimulation();
 
+  /**
+   * Skips the iterations of loops whose timing has become periodic, 
+   * executing them in the functional model and advancing the clock and 
+   * counters by whole periods instead.  The results and counters are the 
+   * same as simulating every cycle, but step() and the run functions may 
+   * pass their target by the cycles skipped.  Ignored when anything that 
+   * records every cycle or instruction is enabled at start(): a verbose 
+   * dump, a trace, co-simulation, callbacks or any optional counters.
+   */
+  void enableFastForward();
+
+  /**
+   * Stops run() after cycles cycles.
+   */
+  void setCycleLimit(std::size_t cycles);
+
+  /**
+   * Stops run() after it has taken limit of host time.
+   */
+  void setTimeLimit(std::chrono::milliseconds limit);
+
+  /**
+   * Stops run() after cycles consecutive cycles in which nothing issued, 
+   * executed, wrote to the CDB or retired.  Progress is checked every 1024 
+   * cycles, so a stretch without it is counted in whole intervals.
+   */
+  void setDeadlockLimit(std::size_t cycles);
+
+  /**
+   * Where run() describes the machine state when it stops at a limit.  The 
+   * program's output is used unless this is set.
+   */
+  void setDiagnosisOutput(std::ostream& os);
+
+  /**
+   * Why the last run() returned.  When it stopped at a limit, the machine 
+   * state was described to the diagnosis output and the counters cover the 
+   * cycles simulated.
+   */
+  RunOutcome outcome() const;
+
+  /**
+   * The most cycles without progress the deadlock watchdog counted in the 
+   * last run(), or the largest std::size_t when it had no deadlock limit.  
+   * The same program stops at any deadlock limit not above this.
+   */
+  std::size_t longestIdle() const;
+
+  void setIssueCallback(IssueCallback callback);
+  void setCommitCallback(CommitCallback callback);
+  void setRetireCallback(RetireCallback callback);
+
+  /**
+   * Prepares to execute from entryPoint.  step() and the run functions 
+   * start from address 0 when this has not been called.
+   */
+  void start(Address entryPoint = 0);
+
+  /**
+   * Simulates up to cycles cycles, stopping early when the program finishes.  
+   * Returns the number of cycles simulated.
+   */
+  std::size_t step(std::size_t cycles = 1);
+
+  /**
+   * Simulates until done returns true, checked before every cycle, or the 
+   * program finishes.  Returns whether done returned true.
+   */
+  bool runUntil(const std::function<bool(const Tomasulo&)>& done);
+  bool runUntilCycle(std::size_t clock);
+  bool runUntilPC(Address address);
+
+  /**
+   * Simulates until the program finishes.
+   */
   void run(Address entryPoint = 0);
 
+  /**
+   * Returns to the state after construction without reallocating any 
+   * component, so one instance can run many programs.  Memory is cleared, 
+   * ready for the next program to be loaded, and every option set since 
+   * construction must be set again.
+   */
+  void reset();
+
 private:
+  void cycle();
+  void finish();
+  /**
+   * Checks the limits of run(), setting runOutcome when one is reached.
+   */
+  bool withinLimits();
+  uint64_t activity() const;
+  void dumpDiagnosis(std::ostream& os);
+  SimulationEvents& getEvents();
   void issue();
+  void nextReplayRecord();
   void execute();
   void write();
   void advanceInstructions();
+  void updateCounters();
+  void lap(HostStage stage);
   bool functionalUnitsIdle() const;
-  void dumpState() const;
-  void dumpRegisters() const;
+  void dumpState();
+  void dumpRegisters(bool full, std::ostream& os = std::cout);
 };
 
 #endif
@@ -35,6 +35,11 @@ UWord Instruction::getImmediate() const
   return immediate;
 }
 
+Address Instruction::getAddress() const
+{
+  return address;
+}
+
 WriteAction Instruction::getWriteAction() const
 {
   return WriteAction::None;
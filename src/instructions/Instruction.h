@@ -28,6 +28,7 @@ private:
   InstructionName name;
   FunctionalUnitType type;
   UWord immediate;
+  Address address;
 
 protected:
   RegisterID rd;
@@ -44,6 +45,11 @@ public:
   virtual RegisterID getArg2() const;
   UWord getImmediate() const;
 
+  /**
+   * Get the address the instruction was fetched from.
+   */
+  Address getAddress() const;
+
   /**
    * Perform the execute action for this instruction and return its result.
    */
@@ -12,10 +12,11 @@
 static const std::string TAG = "InstructionFactory";
 
 InstructionFactory::InstructionFactory(Address& pc, MemoryPtr memory,
-  RegisterFilePtr registers)
+  RegisterFilePtr registers, std::ostream& output)
   : pc(pc),
     memory(memory),
     registers(registers),
+    output(output),
     instruction(),
     name(),
     encodingType(),
@@ -73,7 +74,7 @@ void InstructionFactory::createInstruction()
     break;
 
   case FunctionalUnitType::Trap:
-    result = InstructionPtr(new TrapInstruction(memory, registers));
+    result = InstructionPtr(new TrapInstruction(memory, registers, output));
     break;
 
   case FunctionalUnitType::Branch:
@@ -95,6 +96,7 @@ void InstructionFactory::createInstruction()
 
   result->name = name;
   result->type = fuType;
+  result->address = pc;
 }
 
 void InstructionFactory::decodeItype()
@@ -4,6 +4,7 @@
 #include "instructions/Instruction.h"
 #include "Memory.h"
 #include "RegisterFile.h"
+#include <ostream>
 
 class InstructionFactory;
 using InstructionFactoryPtr = Pointer<InstructionFactory>;
@@ -14,6 +15,7 @@ private:
   Address& pc;
   MemoryPtr memory;
   RegisterFilePtr registers;
+  std::ostream& output;
 
   UWord instruction;
   InstructionName name;
@@ -22,8 +24,11 @@ private:
   InstructionPtr result;
 
 public:
+  /**
+   * Trap instructions write the program's output to output.
+   */
   explicit InstructionFactory(Address& pc, MemoryPtr memory,
-    RegisterFilePtr registers);
+    RegisterFilePtr registers, std::ostream& output);
   InstructionFactory& operator=(InstructionFactory&) = delete;
 
   /**
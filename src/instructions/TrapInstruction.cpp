@@ -8,10 +8,12 @@
 
 static const std::string TAG = "TrapInstruction";
 
-TrapInstruction::TrapInstruction(MemoryPtr memory, RegisterFilePtr registers)
+TrapInstruction::TrapInstruction(MemoryPtr memory, RegisterFilePtr registers,
+  std::ostream& output)
   : Instruction(),
    memory(memory),
-   registers(registers)
+   registers(registers),
+   output(output)
 {
   assert(memory != nullptr);
   assert(registers != nullptr);
@@ -24,7 +26,7 @@ Data TrapInstruction::execute(Data arg1, Data arg2) const
   switch (getImmediate())
   {
   case 1:
-    std::cout << arg1.w << std::flush;
+    output << arg1.w << std::flush;
     break;
 
   case 2:
@@ -40,12 +42,12 @@ Data TrapInstruction::execute(Data arg1, Data arg2) const
       {
         str.push_back('0');
       }
-      std::cout << str << std::flush;
+      output << str << std::flush;
     }
     break;
 
   case 3:
-    std::cout << memory->readString(arg1.uw) << std::flush;
+    output << memory->readString(arg1.uw) << std::flush;
     break;
 
   default:
@@ -5,6 +5,7 @@
 #include "instructions/Instruction.h"
 #include "Memory.h"
 #include "RegisterFile.h"
+#include <ostream>
 
 class TrapInstruction
   : public Instruction
@@ -12,9 +13,12 @@ class TrapInstruction
 private:
   MemoryPtr memory;
   RegisterFilePtr registers;
+  // where the program's output is written
+  std::ostream& output;
 
 public:
-  TrapInstruction(MemoryPtr memory, RegisterFilePtr registers);
+  TrapInstruction(MemoryPtr memory, RegisterFilePtr registers, 
+    std::ostream& output);
 
   virtual Data execute(Data arg1, Data arg2) const override;
   virtual WriteAction getWriteAction() const override;
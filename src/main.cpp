@@ -1,7 +1,12 @@
 #include "log.h"
 #include "Memory.h"
 #include "Tomasulo.h"
+#include "Loader.h"
+#include "FunctionalModel.h"
 #include "Exceptions.h"
+#include "Server.h"
+#include "ResultCache.h"
+#include "MachineConfig.h"
 #include "log/FileLogWriter.h"
 #include "log/StreamLogWriter.h"
 #include "log/ILogFormatter.h"
@@ -15,13 +20,19 @@
 #include <fstream>
 #include <cctype>
 #include <sstream>
+#include <thread>
+#include <algorithm>
+#include <cmath>
 
 using namespace util;
 
 static const std::string TAG = "main";
-static const std::size_t TOMASULO_MEMORY_SIZE = 4 * 1024;
-static const std::string FILE_EXT = ".hex";
-static const std::string HEX_DIGIT = "0123456789abcdefABCDEF";
+
+// exit codes of runs stopped by --max-cycles, --time-limit and 
+// --deadlock-cycles
+static const int EXIT_CYCLE_LIMIT = 3;
+static const int EXIT_TIME_LIMIT = 4;
+static const int EXIT_DEADLOCK = 5;
 
 const StrongLogPtr logger(new Log("tomasulo log"));
 
@@ -49,10 +60,43 @@ public:
 struct ArgPack
 {
   bool verbose;
+  bool deltaDump;
+  std::size_t keyframeInterval;
   std::string fileName;
   LogLevel logLevel;
   bool logConsole;
   std::string logFileName;
+  std::string statsFileName;
+  bool statsJson;
+  std::string profileFileName;
+  std::size_t profileTop;
+  std::string cpiFileName;
+  std::size_t cpiInterval;
+  std::string pipeviewFileName;
+  bool pipeviewChrome;
+  std::size_t pipeviewSize;
+  std::string occupancyFileName;
+  std::string recordTraceFileName;
+  std::string replayTraceFileName;
+  std::size_t replayFirstChunk;
+  std::size_t replayChunkCount;
+  bool coSimulate;
+  bool fastForward;
+  std::string intervalsFileName;
+  std::size_t intervalLength;
+  IntervalUnit intervalUnit;
+  IntervalFormat intervalFormat;
+  std::string dataflowFileName;
+  std::string dataflowLogFileName;
+  std::size_t dataflowTop;
+  std::string hostProfileFileName;
+  std::string serveSocketPath;
+  std::size_t serveWorkers;
+  std::string resultCacheDir;
+  std::size_t resultCacheMegabytes;
+  std::size_t maxCycles;
+  std::chrono::milliseconds timeLimit;
+  std::size_t deadlockCycles;
 };
 
 /**
@@ -61,9 +105,67 @@ struct ArgPack
 static bool parseArgs(int argc, char* argv[], ArgPack& out);
 
 /**
- * Populates memory with the contents of a .hex file.
+ * Whether a ResultCache keeps everything the options ask for, and a cached 
+ * result can stand in for the run.
+ */
+static bool isCacheable(const ArgPack& args);
+
+/**
+ * Opens filename into file and returns it, or returns stdout if the name is 
+ * "-".  Returns nullptr if the file cannot be opened.
+ */
+static std::ostream* openOutput(const std::string& filename, 
+  std::ofstream& file, std::ios::openmode mode = std::ios::out);
+
+/**
+ * Writes the performance counters to a file, or stdout if the name is "-".
+ */
+static bool writeStats(const PerformanceCounters& counters, 
+  const std::string& filename, bool json);
+
+/**
+ * Writes the statistics of a cached result to a file, or stdout if the name 
+ * is "-".
+ */
+static bool writeCachedStats(const CachedResult& result, 
+  const std::string& filename, bool json);
+
+/**
+ * Writes the PC profile to a file, or stdout if the name is "-".
+ */
+static bool writeProfile(const PCProfile& profile, const SourceListing& source,
+  const std::string& filename, std::size_t numHottest);
+
+/**
+ * Writes the CPI stack to a file, or stdout if the name is "-".
+ */
+static bool writeCPIStack(const CPIStack& stack, const std::string& filename);
+
+/**
+ * Writes the pipeline trace to a file, or stdout if the name is "-".
+ */
+static bool writePipelineTrace(const PipelineTrace& trace, 
+  const SourceListing& source, const std::string& filename, bool chrome);
+
+/**
+ * Writes the occupancy histograms to a file, or stdout if the name is "-".
+ */
+static bool writeOccupancy(const Occupancy& occupancy, 
+  const std::string& filename);
+
+/**
+ * Analyzes the dataflow log, then writes the report to a file, or stdout if 
+ * the name is "-".
+ */
+static bool writeDataflow(const std::string& logFileName, 
+  const SourceListing& source, const PerformanceCounters& counters, 
+  const std::string& filename, std::size_t numHottest);
+
+/**
+ * Writes the host profile to a file, or stdout if the name is "-".
  */
-static bool loadFromFile(Memory& mem, const std::string& filename);
+static bool writeHostProfile(const HostProfile& profile, 
+  const PerformanceCounters& counters, const std::string& filename);
 
 int main(int argc, char* argv[])
 {
@@ -97,17 +199,273 @@ int main(int argc, char* argv[])
 
   try
   {
-    MemoryPtr memory(new Memory(TOMASULO_MEMORY_SIZE));
-    if (!loadFromFile(*memory, args.fileName))
+    if (!args.serveSocketPath.empty())
+    {
+      Server server(args.serveSocketPath, args.serveWorkers, MEMORY_SIZE, 
+        Server::JobLimits{ args.maxCycles, args.timeLimit, 
+          args.deadlockCycles });
+      if (!server.listen())
+      {
+        std::cerr << "Unable to listen on " << args.serveSocketPath 
+          << std::endl;
+        return 1;
+      }
+      // only returns when the socket fails
+      server.run();
+      return 1;
+    }
+
+    HostProfilePtr hostProfile(nullptr);
+    if (!args.hostProfileFileName.empty())
+    {
+      hostProfile = HostProfilePtr(new HostProfile);
+      hostProfile->start();
+    }
+
+    // a replayed trace does not need the program, but its source is still 
+    // used by the reports
+    MemoryPtr memory(new Memory(MEMORY_SIZE));
+    SourceListing source;
+    if (!args.fileName.empty() 
+      && !loadFromFile(*memory, args.fileName, &source))
     {
       std::cerr << "Error reading file " << args.fileName << std::endl;
       return 1;
     }
+    if (hostProfile)
+    {
+      hostProfile->lap(HostStage::Load);
+    }
+
+    ResultCachePtr resultCache(nullptr);
+    std::string resultKey;
+    if (!args.resultCacheDir.empty() && isCacheable(args))
+    {
+      resultCache = ResultCachePtr(new ResultCache(args.resultCacheDir, 
+        static_cast<uint64_t>(args.resultCacheMegabytes) * 1024 * 1024, 
+        simulatorVersion()));
+      if (!resultCache->open())
+      {
+        std::cerr << "Unable to use result cache " << args.resultCacheDir 
+          << std::endl;
+        return 1;
+      }
+
+      resultKey = resultCache->key(*memory);
+      // a limit the cached run stayed within would not stop it now
+      CachedResult result;
+      if (resultCache->find(resultKey, result)
+        && (args.maxCycles == 0 || result.cycles <= args.maxCycles)
+        && (args.deadlockCycles == 0 
+          || result.idleCycles < args.deadlockCycles))
+      {
+        std::cout << result.output << std::flush;
+        logger->info(TAG) << "Execution finished in " << result.cycles
+          << " cycles (cached), final state " << result.stateDigest;
+        if (!args.statsFileName.empty() 
+          && !writeCachedStats(result, args.statsFileName, args.statsJson))
+        {
+          std::cerr << "Unable to write statistics to " << args.statsFileName
+            << std::endl;
+          return 1;
+        }
+        return 0;
+      }
+    }
+
+    if (!args.recordTraceFileName.empty())
+    {
+      TraceWriter trace(args.recordTraceFileName);
+      FunctionalModel model(memory);
+      model.run(&trace);
+      if (!trace.close())
+      {
+        std::cerr << "Unable to write trace to " << args.recordTraceFileName
+          << std::endl;
+        return 1;
+      }
+      logger->info(TAG) << "Recorded " << model.instructions() 
+        << " instructions";
+      return 0;
+    }
 
-    Tomasulo tomasulo(memory, args.verbose);
+    // a cached result needs a copy of the trap output
+    RecordingBuffer recording(std::cout);
+    std::ostream recordingStream(&recording);
+    Tomasulo tomasulo(memory, args.verbose, args.deltaDump, 
+      args.keyframeInterval, resultCache ? recordingStream : std::cout);
+    if (!args.profileFileName.empty())
+    {
+      tomasulo.enablePCProfile();
+    }
+    if (!args.cpiFileName.empty())
+    {
+      tomasulo.enableCPIStack(args.cpiInterval);
+    }
+    if (!args.pipeviewFileName.empty())
+    {
+      tomasulo.enablePipelineTrace(args.pipeviewSize);
+    }
+    if (!args.occupancyFileName.empty())
+    {
+      tomasulo.enableOccupancy();
+    }
+    std::ofstream intervalsFile;
+    if (!args.intervalsFileName.empty())
+    {
+      auto intervals = openOutput(args.intervalsFileName, intervalsFile, 
+        std::ios::out | std::ios::binary);
+      if (!intervals)
+      {
+        std::cerr << "Unable to write interval statistics to " 
+          << args.intervalsFileName << std::endl;
+        return 1;
+      }
+      tomasulo.enableIntervalStats(*intervals, args.intervalUnit, 
+        args.intervalLength, args.intervalFormat);
+    }
+    if (!args.replayTraceFileName.empty())
+    {
+      TraceReaderPtr trace(new TraceReader(args.replayTraceFileName));
+      if (!trace->good())
+      {
+        std::cerr << "Error reading trace " << args.replayTraceFileName 
+          << std::endl;
+        return 1;
+      }
+      if (!trace->selectChunks(args.replayFirstChunk, args.replayChunkCount))
+      {
+        std::cerr << "The trace only has " << trace->chunks() << " chunks"
+          << std::endl;
+        return 1;
+      }
+      tomasulo.setReplayTrace(trace);
+    }
+    if (args.coSimulate)
+    {
+      tomasulo.enableCoSimulation();
+    }
+    if (args.fastForward)
+    {
+      tomasulo.enableFastForward();
+    }
+    tomasulo.setCycleLimit(args.maxCycles);
+    tomasulo.setTimeLimit(args.timeLimit);
+    tomasulo.setDeadlockLimit(args.deadlockCycles);
+    DataflowLogPtr dataflowLog;
+    if (!args.dataflowFileName.empty())
+    {
+      dataflowLog = DataflowLogPtr(new DataflowLog(args.dataflowLogFileName));
+      if (!dataflowLog->good())
+      {
+        std::cerr << "Unable to write dataflow log to " 
+          << args.dataflowLogFileName << std::endl;
+        return 1;
+      }
+      tomasulo.setDataflowLog(dataflowLog);
+    }
+    if (hostProfile)
+    {
+      tomasulo.setHostProfile(hostProfile);
+    }
     tomasulo.run();
     logger->info(TAG) << "Execution finished in " << tomasulo.clocks()
       << " cycles";
+    if (resultCache && tomasulo.outcome() == RunOutcome::Finished)
+    {
+      CachedResult result;
+      ResultCache::describe(tomasulo, recording.str(), result);
+      logger->info(TAG) << "Final state " << result.stateDigest;
+      resultCache->store(resultKey, result);
+    }
+
+    if (!args.statsFileName.empty() 
+      && !writeStats(tomasulo.counters(), args.statsFileName, args.statsJson))
+    {
+      std::cerr << "Unable to write statistics to " << args.statsFileName
+        << std::endl;
+      return 1;
+    }
+    if (!args.profileFileName.empty()
+      && !writeProfile(*tomasulo.counters().pcProfile, source, 
+        args.profileFileName, args.profileTop))
+    {
+      std::cerr << "Unable to write profile to " << args.profileFileName
+        << std::endl;
+      return 1;
+    }
+    if (!args.cpiFileName.empty()
+      && !writeCPIStack(*tomasulo.counters().cpiStack, args.cpiFileName))
+    {
+      std::cerr << "Unable to write CPI stack to " << args.cpiFileName
+        << std::endl;
+      return 1;
+    }
+    if (!args.pipeviewFileName.empty()
+      && !writePipelineTrace(*tomasulo.counters().pipelineTrace, source,
+        args.pipeviewFileName, args.pipeviewChrome))
+    {
+      std::cerr << "Unable to write pipeline trace to " 
+        << args.pipeviewFileName << std::endl;
+      return 1;
+    }
+    if (intervalsFile.is_open() && !intervalsFile)
+    {
+      std::cerr << "Unable to write interval statistics to " 
+        << args.intervalsFileName << std::endl;
+      return 1;
+    }
+    if (!args.occupancyFileName.empty()
+      && !writeOccupancy(*tomasulo.counters().occupancy, 
+        args.occupancyFileName))
+    {
+      std::cerr << "Unable to write occupancy to " << args.occupancyFileName
+        << std::endl;
+      return 1;
+    }
+    if (dataflowLog && (!dataflowLog->close() 
+      || !writeDataflow(args.dataflowLogFileName, source, tomasulo.counters(),
+        args.dataflowFileName, args.dataflowTop)))
+    {
+      std::cerr << "Unable to write dataflow analysis to " 
+        << args.dataflowFileName << std::endl;
+      return 1;
+    }
+    if (hostProfile && !writeHostProfile(*hostProfile, tomasulo.counters(),
+      args.hostProfileFileName))
+    {
+      std::cerr << "Unable to write host profile to " 
+        << args.hostProfileFileName << std::endl;
+      return 1;
+    }
+
+    // the reports above cover the cycles simulated before the stop
+    switch (tomasulo.outcome())
+    {
+    case RunOutcome::Finished:
+      break;
+
+    case RunOutcome::CycleLimit:
+      std::cerr << "Stopped after " << tomasulo.clocks() 
+        << " cycles, the cycle limit" << std::endl;
+      return EXIT_CYCLE_LIMIT;
+
+    case RunOutcome::TimeLimit:
+      std::cerr << "Stopped at cycle " << tomasulo.clocks() 
+        << ", the time limit was reached" << std::endl;
+      return EXIT_TIME_LIMIT;
+
+    case RunOutcome::Deadlock:
+      std::cerr << "Stopped at cycle " << tomasulo.clocks() 
+        << ", no progress was made for " << args.deadlockCycles 
+        << " cycles" << std::endl;
+      return EXIT_DEADLOCK;
+    }
+  }
+  catch (DivergenceException& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
   }
   catch (Exception& e)
   {
@@ -146,8 +504,16 @@ bool parseArgs(int argc, char* argv[], ArgPack& out)
     SwitchArg verbose("v", "verbose",
       "Enable extra output about the processor state", cmd, false
       );
-    ValueArg<std::string> fileName("f", "file", "The input program file",
-      true, "", "string", cmd
+    SwitchArg deltaDump("d", "delta",
+      "With --verbose, only print the processor state that changed each cycle",
+      cmd, false
+      );
+    ValueArg<std::size_t> keyframeInterval("", "keyframe",
+      "With --delta, print the full processor state every N cycles (0 = only "
+      "the first cycle)", false, 0, "N", cmd
+      );
+    ValueArg<std::string> fileName("f", "file", "The input program file, "
+      "required unless replaying a trace", false, "", "string", cmd
       );
     std::vector<std::string> logLevels{ "verbose", "debug", "info", "warning",
       "error"
@@ -163,13 +529,208 @@ bool parseArgs(int argc, char* argv[], ArgPack& out)
       "The output file for logging information", false, "tomasulo.log", "path", 
       cmd
       );    
+    ValueArg<std::string> statsFileName("", "stats",
+      "Write performance counters to a file when the program finishes ('-' "
+      "for stdout)", false, "", "path", cmd
+      );
+    std::vector<std::string> statsFormats{ "text", "json" };
+    ValuesConstraint<std::string> statsFormatConstraint(statsFormats);
+    ValueArg<std::string> statsFormat("", "stats-format", 
+      "The format of the --stats output", false, "text", 
+      &statsFormatConstraint, cmd
+      );
+    ValueArg<std::string> profileFileName("", "profile",
+      "Write a listing annotated with the cycles attributed to each "
+      "instruction when the program finishes ('-' for stdout)", false, "", 
+      "path", cmd
+      );
+    ValueArg<std::size_t> profileTop("", "profile-top",
+      "The number of addresses in the --profile hottest PC report", false, 10,
+      "N", cmd
+      );
+    ValueArg<std::string> cpiFileName("", "cpi",
+      "Write a breakdown of the cycles into issue, stall and drain components "
+      "when the program finishes ('-' for stdout)", false, "", "path", cmd
+      );
+    ValueArg<std::size_t> cpiInterval("", "cpi-interval",
+      "Also break down every N cycles in the --cpi report (0 disables)", 
+      false, 0, "N", cmd
+      );
+    ValueArg<std::string> pipeviewFileName("", "pipeview",
+      "Write the issue, execute and write cycles of each instruction for a "
+      "pipeline visualizer ('-' for stdout)", false, "", "path", cmd
+      );
+    std::vector<std::string> pipeviewFormats{ "kanata", "chrome" };
+    ValuesConstraint<std::string> pipeviewFormatConstraint(pipeviewFormats);
+    ValueArg<std::string> pipeviewFormat("", "pipeview-format",
+      "The format of the --pipeview output, Kanata (Konata) or Chrome trace "
+      "event JSON (chrome://tracing, Perfetto)", false, "kanata",
+      &pipeviewFormatConstraint, cmd
+      );
+    ValueArg<std::size_t> pipeviewSize("", "pipeview-size",
+      "The number of most recent instructions kept for --pipeview", false, 
+      65536, "N", cmd
+      );
+    ValueArg<std::string> occupancyFileName("", "occupancy",
+      "Write percentiles and distributions of the stations, execute units, "
+      "CDB listeners and CDB write requests in use each cycle ('-' for "
+      "stdout)", false, "", "path", cmd
+      );
+    ValueArg<std::string> recordTraceFileName("", "record-trace",
+      "Execute the program in order without timing, writing every executed "
+      "instruction to a trace file, then exit", false, "", "path", cmd
+      );
+    ValueArg<std::string> replayTraceFileName("", "replay-trace",
+      "Time the instructions of a --record-trace file instead of fetching "
+      "and executing the program", false, "", "path", cmd
+      );
+    ValueArg<std::string> replayChunks("", "replay-chunks",
+      "Only replay count chunks of the trace starting at chunk first (each "
+      "chunk holds 65536 instructions), so parts of a trace can be replayed "
+      "in parallel", false, "", "first[:count]", cmd
+      );
+    SwitchArg coSimulate("", "cosim",
+      "Run the functional model in lockstep, checking every register write "
+      "and store, and stop at the first difference", cmd, false
+      );
+    SwitchArg fastForward("", "fast-forward",
+      "Skip the iterations of loops once their timing repeats, executing them "
+      "functionally and adding whole periods to the cycle and event counts",
+      cmd, false
+      );
+    ValueArg<std::string> intervalsFileName("", "intervals",
+      "Write IPC, occupancy, CDB utilization, stalls and memory accesses for "
+      "each interval while the program runs ('-' for stdout)", false, "", 
+      "path", cmd
+      );
+    ValueArg<std::size_t> intervalLength("", "interval",
+      "The length of each --intervals interval", false, 10000, "N", cmd
+      );
+    std::vector<std::string> intervalUnits{ "cycles", "instructions" };
+    ValuesConstraint<std::string> intervalUnitConstraint(intervalUnits);
+    ValueArg<std::string> intervalUnit("", "interval-unit",
+      "Whether --interval counts cycles or retired instructions", false, 
+      "cycles", &intervalUnitConstraint, cmd
+      );
+    std::vector<std::string> intervalFormats{ "csv", "columnar" };
+    ValuesConstraint<std::string> intervalFormatConstraint(intervalFormats);
+    ValueArg<std::string> intervalFormat("", "intervals-format",
+      "The format of the --intervals output, CSV or binary columns", false, 
+      "csv", &intervalFormatConstraint, cmd
+      );
+    ValueArg<std::string> dataflowFileName("", "dataflow",
+      "Write the dataflow critical path, ideal ILP and the addresses most "
+      "often on the critical path when the program finishes ('-' for stdout)",
+      false, "", "path", cmd
+      );
+    ValueArg<std::string> dataflowLogFileName("", "dataflow-log",
+      "The file recording every issued instruction for --dataflow", false, 
+      "dataflow.log", "path", cmd
+      );
+    ValueArg<std::size_t> dataflowTop("", "dataflow-top",
+      "The number of addresses in the --dataflow critical path report", false,
+      10, "N", cmd
+      );
+    ValueArg<std::string> hostProfileFileName("", "profile-host",
+      "Write the host time spent loading and in each stage of the simulation "
+      "when the program finishes ('-' for stdout)", false, "", "path", cmd
+      );
+    ValueArg<std::size_t> maxCycles("", "max-cycles",
+      "Stop after N cycles, 0 for no limit", false, 0, "N", cmd
+      );
+    ValueArg<double> timeLimit("", "time-limit",
+      "Stop after the simulation has run for this many seconds, 0 for no "
+      "limit", false, 0, "seconds", cmd
+      );
+    ValueArg<std::size_t> deadlockCycles("", "deadlock-cycles",
+      "Stop after N cycles in which nothing issued, executed, wrote to the "
+      "CDB or retired, 0 to never stop", false, 100000, "N", cmd
+      );
+    ValueArg<std::string> resultCacheDir("", "result-cache",
+      "Keep the output and statistics of each program in a directory, and "
+      "reuse them when this build runs the same program again", false, "", 
+      "path", cmd
+      );
+    ValueArg<std::size_t> resultCacheMegabytes("", "result-cache-size",
+      "The most megabytes of results kept by --result-cache", false, 256, 
+      "MB", cmd
+      );
+    ValueArg<std::string> serveSocketPath("", "serve",
+      "Keep running, simulating the jobs sent to a Unix domain socket at "
+      "path and streaming back their output and statistics.  The limits "
+      "apply to each job", false, "", 
+      "path", cmd
+      );
+    ValueArg<std::size_t> serveWorkers("", "serve-workers",
+      "The number of --serve jobs simulated at once", false,
+      std::max(1u, std::thread::hardware_concurrency()), "N", cmd
+      );
 
     cmd.parse(argc, argv);
 
     out.verbose = verbose.getValue();
+    out.deltaDump = deltaDump.getValue();
+    out.keyframeInterval = keyframeInterval.getValue();
     out.fileName = fileName.getValue();
     out.logConsole = logConsole.getValue();
     out.logFileName = logFileName.getValue();
+    out.statsFileName = statsFileName.getValue();
+    out.statsJson = statsFormat.getValue() == "json";
+    out.profileFileName = profileFileName.getValue();
+    out.profileTop = profileTop.getValue();
+    out.cpiFileName = cpiFileName.getValue();
+    out.cpiInterval = cpiInterval.getValue();
+    out.pipeviewFileName = pipeviewFileName.getValue();
+    out.pipeviewChrome = pipeviewFormat.getValue() == "chrome";
+    out.pipeviewSize = pipeviewSize.getValue();
+    out.occupancyFileName = occupancyFileName.getValue();
+    out.recordTraceFileName = recordTraceFileName.getValue();
+    out.replayTraceFileName = replayTraceFileName.getValue();
+    out.replayFirstChunk = 0;
+    out.replayChunkCount = static_cast<std::size_t>(-1);
+    if (!replayChunks.getValue().empty())
+    {
+      char sep = ':';
+      std::istringstream range(replayChunks.getValue());
+      range >> out.replayFirstChunk;
+      if (!range.eof())
+      {
+        range >> sep >> out.replayChunkCount;
+      }
+      if (!range || sep != ':')
+      {
+        std::cerr << "Error: invalid --replay-chunks, expected first[:count]"
+          << std::endl;
+        return false;
+      }
+    }
+    out.coSimulate = coSimulate.getValue();
+    out.fastForward = fastForward.getValue();
+    out.intervalsFileName = intervalsFileName.getValue();
+    out.intervalLength = intervalLength.getValue();
+    out.intervalUnit = intervalUnit.getValue() == "instructions" 
+      ? IntervalUnit::Instructions : IntervalUnit::Cycles;
+    out.intervalFormat = intervalFormat.getValue() == "columnar"
+      ? IntervalFormat::Columnar : IntervalFormat::Csv;
+    out.dataflowFileName = dataflowFileName.getValue();
+    out.dataflowLogFileName = dataflowLogFileName.getValue();
+    out.dataflowTop = dataflowTop.getValue();
+    out.hostProfileFileName = hostProfileFileName.getValue();
+    out.serveSocketPath = serveSocketPath.getValue();
+    out.serveWorkers = serveWorkers.getValue();
+    out.maxCycles = maxCycles.getValue();
+    if (timeLimit.getValue() < 0)
+    {
+      std::cerr << "Error: --time-limit cannot be negative" << std::endl;
+      return false;
+    }
+    // rounded up, so a limit below a millisecond is not taken as no limit
+    out.timeLimit = std::chrono::milliseconds(
+      static_cast<std::chrono::milliseconds::rep>(
+        std::ceil(timeLimit.getValue() * 1000)));
+    out.deadlockCycles = deadlockCycles.getValue();
+    out.resultCacheDir = resultCacheDir.getValue();
+    out.resultCacheMegabytes = resultCacheMegabytes.getValue();
     
     std::string level = logLevel.getValue();
     if (level == "verbose")
@@ -200,96 +761,186 @@ bool parseArgs(int argc, char* argv[], ArgPack& out)
     return false;
   }
 
+  if (out.fileName.empty() && out.replayTraceFileName.empty() 
+    && out.serveSocketPath.empty())
+  {
+    std::cerr << "Error: a program file (-f) is required" << std::endl;
+    return false;
+  }
+  if (!out.recordTraceFileName.empty() && !out.replayTraceFileName.empty())
+  {
+    std::cerr << "Error: --record-trace and --replay-trace cannot be combined"
+      << std::endl;
+    return false;
+  }
+  if (out.coSimulate && !out.replayTraceFileName.empty())
+  {
+    std::cerr << "Error: --cosim and --replay-trace cannot be combined"
+      << std::endl;
+    return false;
+  }
+
   return true;
 }
 
-bool loadFromFile(Memory& mem, const std::string& filename)
+bool isCacheable(const ArgPack& args)
+{
+  return !args.fileName.empty() && !args.verbose 
+    && args.profileFileName.empty() && args.cpiFileName.empty()
+    && args.pipeviewFileName.empty() && args.occupancyFileName.empty()
+    && args.recordTraceFileName.empty() && args.replayTraceFileName.empty()
+    && !args.coSimulate && args.intervalsFileName.empty()
+    && args.dataflowFileName.empty() && args.hostProfileFileName.empty()
+    // whether a time limit fires depends on the host
+    && args.timeLimit.count() == 0;
+}
+
+std::ostream* openOutput(const std::string& filename, std::ofstream& file, 
+  std::ios::openmode mode)
 {
-  bool hasFileExt = filename.compare(
-    filename.length() - FILE_EXT.length(),
-    FILE_EXT.length(), FILE_EXT
-    ) == 0;
-  if (!hasFileExt)
+  if (filename == "-")
+  {
+    return &std::cout;
+  }
+  file.open(filename.c_str(), mode);
+  return file ? &file : nullptr;
+}
+
+bool writeStats(const PerformanceCounters& counters, 
+  const std::string& filename, bool json)
+{
+  std::ofstream file;
+  auto out = openOutput(filename, file);
+  if (!out)
   {
-    logger->error(TAG) << "Invalid file type " << filename;
     return false;
   }
+  std::ostream& os = *out;
 
-  std::ifstream file(filename.c_str(), std::ios::in);
-  if (!file)
+  if (json)
+  {
+    counters.writeJson(os);
+  }
+  else
+  {
+    counters.writeText(os);
+  }
+  return static_cast<bool>(os);
+}
+
+bool writeCachedStats(const CachedResult& result, 
+  const std::string& filename, bool json)
+{
+  std::ofstream file;
+  auto out = openOutput(filename, file);
+  if (!out)
   {
-    logger->error(TAG, "Unable to open file " + filename);
     return false;
   }
+  std::ostream& os = *out;
 
-  std::size_t count = 0;
-  logger->info(TAG, "Loading from file " + filename);
-  while (!file.eof())
+  os << (json ? result.statsJson : result.statsText);
+  return static_cast<bool>(os);
+}
+
+bool writeProfile(const PCProfile& profile, const SourceListing& source,
+  const std::string& filename, std::size_t numHottest)
+{
+  std::ofstream file;
+  auto out = openOutput(filename, file);
+  if (!out)
   {
-    std::string line;
-    std::getline(file, line);
-    //logger->verbose(TAG, "Read line \"" + line + "\"");
+    return false;
+  }
+  std::ostream& os = *out;
 
-    // strip comments
-    auto commentIdx = line.find_first_of('#');
-    if (commentIdx != std::string::npos)
-    {
-      line.resize(commentIdx);
-    }
+  profile.writeReport(os, source, numHottest);
+  return static_cast<bool>(os);
+}
 
-    // relevant data in the line is
-    // [32 bit address]: [bytes...]
-    // A line without a colon is skipped
-    auto colon = line.find(':');
-    if (colon == std::string::npos)
-    {
-      continue;
-    }
+bool writeCPIStack(const CPIStack& stack, const std::string& filename)
+{
+  std::ofstream file;
+  auto out = openOutput(filename, file);
+  if (!out)
+  {
+    return false;
+  }
+  std::ostream& os = *out;
 
+  stack.writeReport(os);
+  return static_cast<bool>(os);
+}
 
-    Address addr;
-    {
-      // pull the address
-      std::istringstream is;
-      is.str(line.substr(0, colon));
-      is >> std::hex >> addr;
-      //logger->verbose(TAG) << "Address: " << util::hex<Address> << addr;
-    }
+bool writePipelineTrace(const PipelineTrace& trace, 
+  const SourceListing& source, const std::string& filename, bool chrome)
+{
+  std::ofstream file;
+  auto out = openOutput(filename, file);
+  if (!out)
+  {
+    return false;
+  }
+  std::ostream& os = *out;
 
-    // find the hex data string after the colon
-    auto start = line.find_first_of(HEX_DIGIT, colon + 1);
-    auto end = line.find_last_of(HEX_DIGIT);
-    std::istringstream is(line.substr(start, end - start + 1));
-    //logger->verbose(TAG, is.str());
+  if (chrome)
+  {
+    trace.writeChromeTrace(os, source);
+  }
+  else
+  {
+    trace.writeKanata(os, source);
+  }
+  return static_cast<bool>(os);
+}
 
-    ByteBuffer buffer;
-    buffer.reserve((end - start) / 2);
-    while (is.rdbuf()->in_avail() > 0)
-    {
-      std::string str;
-      std::stringstream temp;
-      // must use an integer type because streams will treat *any* char type 
-      // as an ascii character rather than an integer
-      UWord byte;
+bool writeOccupancy(const Occupancy& occupancy, const std::string& filename)
+{
+  std::ofstream file;
+  auto out = openOutput(filename, file);
+  if (!out)
+  {
+    return false;
+  }
+  std::ostream& os = *out;
 
-      // pull 2 characters from the stream and convert them through a 
-      // temporary stream buffer
-      // why can't you pull them directly from the stream?  no idea, but if you 
-      // try to do that it ignores the width directive
-      is.width(2);
-      is >> str;
-      temp << str;
-      temp >> std::hex >> byte;
-      buffer.push_back(static_cast<Byte>(byte));
-      //logger->verbose(TAG) << "Byte: " << util::hex<Byte> << byte;
-    }
+  occupancy.writeReport(os);
+  return static_cast<bool>(os);
+}
 
-    count += buffer.size();
-    mem.write(addr, buffer);
-    logger->verbose(TAG) << "Writing " << buffer.size() << " bytes to "
-      << util::hex<Address> << addr;
+bool writeDataflow(const std::string& logFileName, 
+  const SourceListing& source, const PerformanceCounters& counters, 
+  const std::string& filename, std::size_t numHottest)
+{
+  DataflowAnalysis analysis;
+  if (!analysis.analyze(logFileName))
+  {
+    return false;
   }
 
-  logger->verbose(TAG) << "Read in " << count << " bytes";
-  return true;
+  std::ofstream file;
+  auto out = openOutput(filename, file);
+  if (!out)
+  {
+    return false;
+  }
+  std::ostream& os = *out;
+
+  analysis.writeReport(os, source, counters.cycles, numHottest);
+  return static_cast<bool>(os);
+}
+
+bool writeHostProfile(const HostProfile& profile, 
+  const PerformanceCounters& counters, const std::string& filename)
+{
+  std::ofstream file;
+  auto out = openOutput(filename, file);
+  if (!out)
+  {
+    return false;
+  }
+  std::ostream& os = *out;
+
+  profile.writeReport(os, counters.cycles, counters.retired());
+  return static_cast<bool>(os);
 }